@@ -0,0 +1,259 @@
+#ifndef SPACE_TCP_COMPRESSION_HPP
+#define SPACE_TCP_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unistd.h>
+
+namespace space_tcp {
+
+// Byte-oriented LZ77 compression in the spirit of LZ4. Compressed data is a
+// series of sequences:
+//
+//     token | literal length* | literals | offset (2 B, LE) | match length*
+//
+// The upper nibble of the token holds the number of literals, the lower
+// nibble the match length minus LZ_MIN_MATCH. A nibble of 15 continues in
+// extra bytes, each adding up to 255. An offset of 0 ends a sequence without
+// a match, i.e., independently compressed blocks can be concatenated.
+//
+// The decompressor works in place: the compressed data is moved to the end
+// of the buffer and decompressed towards its start. The compressor only
+// accepts results which decompress in place given LZ_IN_PLACE_MARGIN bytes
+// beyond the decompressed data, so receivers need no extra buffer.
+
+/// Shortest match worth an offset.
+constexpr size_t LZ_MIN_MATCH = 4;
+
+/// Spare bytes behind the decompressed data during in-place decompression.
+constexpr size_t LZ_IN_PLACE_MARGIN = 16;
+
+/// Compressor with a hash table of recent positions, the only state kept
+/// between calls. The table lives in the compressor, i.e., compression does
+/// not allocate memory.
+class LzCompressor {
+public:
+    /// Inputs below this size are not compressed.
+    static constexpr size_t MIN_INPUT = 32;
+
+    static auto create() -> LzCompressor {
+        return {};
+    }
+
+    /// Compresses the `first_len` bytes at `first` followed by the
+    /// `second_len` bytes at `second`, e.g., data wrapped around a ring
+    /// buffer, to `dst`. The parts are compressed as independent blocks.
+    /// Returns the compressed size, 0 if the data is shorter than MIN_INPUT,
+    /// does not shrink or cannot be decompressed in place.
+    auto compress(const uint8_t *first, size_t first_len, const uint8_t *second, size_t second_len,
+                  uint8_t *dst) -> size_t {
+        auto len = first_len + second_len;
+
+        if (len < MIN_INPUT || len > 0xffff) {
+            return 0;
+        }
+
+        out = dst;
+        capacity = len - 1;
+        written = 0;
+        produced = 0;
+        max_deficit = 0;
+
+        if (!compress_block(first, first_len) || !compress_block(second, second_len)) {
+            return 0;
+        }
+
+        // the receiver has the decompressed size plus the margin at hand
+        if (max_deficit > len - written + LZ_IN_PLACE_MARGIN) {
+            return 0;
+        }
+
+        return written;
+    }
+
+private:
+    LzCompressor() = default;
+
+    static constexpr size_t HASH_BITS = 10;
+
+    static auto hash(const uint8_t *data) -> size_t {
+        uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    auto compress_block(const uint8_t *src, size_t len) -> bool {
+        size_t anchor = 0;
+        size_t pos = 0;
+
+        while (len >= LZ_MIN_MATCH && pos <= len - LZ_MIN_MATCH) {
+            auto slot = hash(src + pos);
+            size_t candidate = table[slot];
+            table[slot] = static_cast<uint16_t>(pos);
+
+            // entries of earlier blocks point anywhere, check the bytes
+            if (candidate >= pos || pos - candidate > 0xffff ||
+                src[candidate] != src[pos] || src[candidate + 1] != src[pos + 1] ||
+                src[candidate + 2] != src[pos + 2] || src[candidate + 3] != src[pos + 3]) {
+                pos++;
+                continue;
+            }
+
+            auto match = LZ_MIN_MATCH;
+            while (pos + match < len && src[candidate + match] == src[pos + match]) {
+                match++;
+            }
+
+            if (!emit(src + anchor, pos - anchor, pos - candidate, match)) {
+                return false;
+            }
+
+            pos += match;
+            anchor = pos;
+        }
+
+        if (anchor < len) {
+            return emit(src + anchor, len - anchor, 0, 0);
+        }
+
+        return true;
+    }
+
+    auto emit(const uint8_t *literals, size_t literal_len, size_t offset, size_t match) -> bool {
+        auto match_code = offset ? match - LZ_MIN_MATCH : 0;
+
+        if (!put(static_cast<uint8_t>(((literal_len < 15) ? literal_len : 15) << 4 |
+                                      ((match_code < 15) ? match_code : 15))) ||
+            !put_length(literal_len)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < literal_len; i++) {
+            if (!put(literals[i])) {
+                return false;
+            }
+        }
+
+        if (!put(static_cast<uint8_t>(offset)) || !put(static_cast<uint8_t>(offset >> 8)) ||
+            (offset && !put_length(match_code))) {
+            return false;
+        }
+
+        produced += literal_len + (offset ? match : 0);
+
+        // decompressed data ahead of the compressed data read so far
+        if (produced > written && produced - written > max_deficit) {
+            max_deficit = produced - written;
+        }
+
+        return true;
+    }
+
+    // extra bytes of a length whose nibble is 15
+    auto put_length(size_t len) -> bool {
+        if (len < 15) {
+            return true;
+        }
+
+        for (len -= 15; len >= 255; len -= 255) {
+            if (!put(255)) {
+                return false;
+            }
+        }
+
+        return put(static_cast<uint8_t>(len));
+    }
+
+    auto put(uint8_t byte) -> bool {
+        if (written == capacity) {
+            return false;
+        }
+
+        out[written++] = byte;
+
+        return true;
+    }
+
+    uint16_t table[1 << HASH_BITS]{};
+
+    uint8_t *out{};
+    size_t capacity{};
+    size_t written{};
+    size_t produced{};
+    size_t max_deficit{};
+};
+
+/// Decompresses the `len` bytes of compressed data at the end of `buffer`,
+/// which holds `capacity` bytes, to the start of the buffer. Returns the
+/// decompressed size, -1 if the data is malformed or the decompressed data
+/// would overwrite compressed data not read yet.
+inline auto lz_decompress(uint8_t *buffer, size_t capacity, size_t len) -> ssize_t {
+    if (len > capacity) {
+        return -1;
+    }
+
+    size_t in = capacity - len;
+    size_t out = 0;
+
+    auto read_length = [&](size_t &length) {
+        if (length < 15) {
+            return true;
+        }
+
+        uint8_t byte;
+
+        do {
+            if (in == capacity) {
+                return false;
+            }
+
+            byte = buffer[in++];
+            length += byte;
+        } while (byte == 255);
+
+        return true;
+    };
+
+    while (in < capacity) {
+        auto token = buffer[in++];
+        size_t literal_len = token >> 4;
+        size_t match = token & 0xf;
+
+        if (!read_length(literal_len) || capacity - in < literal_len + 2) {
+            return -1;
+        }
+
+        // literals move forward as long as writing stays behind reading
+        for (size_t i = 0; i < literal_len; i++) {
+            buffer[out++] = buffer[in++];
+        }
+
+        size_t offset = buffer[in] | (buffer[in + 1] << 8);
+        in += 2;
+
+        if (offset == 0) {
+            continue;
+        }
+
+        if (!read_length(match)) {
+            return -1;
+        }
+
+        match += LZ_MIN_MATCH;
+
+        if (offset > out || out + match > in) {
+            return -1;
+        }
+
+        // byte by byte, matches may overlap their own output
+        for (size_t i = 0; i < match; i++, out++) {
+            buffer[out] = buffer[out - offset];
+        }
+    }
+
+    return static_cast<ssize_t>(out);
+}
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_COMPRESSION_HPP
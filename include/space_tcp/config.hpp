@@ -0,0 +1,87 @@
+#ifndef SPACE_TCP_CONFIG_HPP
+#define SPACE_TCP_CONFIG_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Default configuration of S3TP endpoints and their connections.
+///
+/// Endpoints are configured at compile time. To tune an endpoint for a
+/// specific link, derive from this struct and hide the values to change:
+///
+///     struct UhfConfig : space_tcp::DefaultConfig {
+///         static constexpr size_t PAYLOAD_SIZE = 128;
+///         static constexpr size_t WINDOW_SIZE = 8;
+///     };
+///
+///     space_tcp::Connections<4, UhfConfig> connections;
+///
+/// Endpoints with different configurations can be used side by side.
+struct DefaultConfig {
+    /// Payload of a S3TP packet (bytes) if the network does not report its
+    /// MTU or the remote host does not announce a maximum segment size.
+    static constexpr size_t PAYLOAD_SIZE = 512;
+
+    /// Upper bound for payloads (bytes) on networks with a large MTU.
+    static constexpr size_t MAX_PAYLOAD_SIZE = 65024;
+
+    /// Maximum number of packets in flight per connection.
+    static constexpr size_t WINDOW_SIZE = 32;
+
+    /// Maximum number of packets in flight per connection with 32-bit
+    /// sequence numbers.
+    static constexpr size_t EXTENDED_WINDOW_SIZE = 512;
+
+    /// Retransmit missing packets after this time (ms) until the round-trip
+    /// time of the connection has been measured.
+    static constexpr uint64_t RETRANSMISSION_TIMEOUT = 100;
+
+    /// Lower bound for the retransmission timeout (ms).
+    static constexpr uint64_t MIN_RETRANSMISSION_TIMEOUT = 50;
+
+    /// Upper bound for the retransmission timeout (ms), also for the timeout
+    /// backed off on repeated expiry.
+    static constexpr uint64_t MAX_RETRANSMISSION_TIMEOUT = 60000;
+
+    /// Retransmit the oldest unacknowledged segment after this many duplicate
+    /// ACKs, 0 disables fast retransmit.
+    static constexpr size_t DUP_ACK_THRESHOLD = 3;
+
+    /// Acknowledge every ACK_RATIO-th segment received in order, 1 acknowledges
+    /// each segment. Segments received out of order or filling a gap are
+    /// acknowledged right away.
+    static constexpr size_t ACK_RATIO = 2;
+
+    /// Acknowledge segments received in order after this time (ms) at the
+    /// latest. Has to stay below MIN_RETRANSMISSION_TIMEOUT.
+    static constexpr uint64_t ACK_DELAY = 20;
+
+    /// Slots of the timer wheel of an endpoint, a power of two. Each slot
+    /// covers 1 ms, TX timers further ahead take more than one turn.
+    static constexpr size_t TIMER_SLOTS = 256;
+
+    /// Cool-off period for closing connections (s).
+    static constexpr uint64_t TIMEWAIT = 3;
+
+    /// Maximum number of packets handled at once by rx_burst() and tx_burst().
+    static constexpr size_t BURST_SIZE = 32;
+
+    /// Packets sent back to back before pacing spaces them to the rate of the
+    /// network or connection.
+    static constexpr size_t PACING_BURST = 4;
+
+    /// Share of the connection buffer used for received data (percent), the
+    /// rest of the buffer holds data to be transmitted.
+    static constexpr size_t RX_BUFFER_SHARE = 50;
+
+    /// Segments sent uncompressed after a segment of a compressing
+    /// connection did not shrink, i.e., incompressible data costs a failed
+    /// attempt every COMPRESSION_BACKOFF segments only.
+    static constexpr size_t COMPRESSION_BACKOFF = 8;
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_CONFIG_HPP
@@ -0,0 +1,173 @@
+#ifndef SPACE_TCP_CONGESTION_HPP
+#define SPACE_TCP_CONGESTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Interface for congestion controllers. A controller limits the data in
+/// flight of a single connection below its static window, based on the ACKs
+/// and round-trip time samples of the connection. Controllers are owned by
+/// the application and must not be shared between connections.
+class CongestionController {
+public:
+    virtual ~CongestionController() = default;
+
+    /// Starts over with segments of `mss` bytes, e.g., when the connection
+    /// is established.
+    virtual void reset(size_t mss) = 0;
+
+    /// Called for each ACK which acknowledges `acked` new bytes while
+    /// `in_flight` bytes were unacknowledged. `rtt` is the round-trip time
+    /// (ms) measured with this ACK, 0 if the ACK gives no sample.
+    virtual void acknowledged(size_t acked, size_t in_flight, uint64_t rtt) = 0;
+
+    /// Called when duplicate ACKs or selective acknowledgments indicate a
+    /// lost segment while `in_flight` bytes were unacknowledged.
+    virtual void lost(size_t in_flight) = 0;
+
+    /// Called when the TX timer expired while `in_flight` bytes were
+    /// unacknowledged.
+    virtual void timed_out(size_t in_flight) = 0;
+
+    /// Returns the amount of data (bytes) allowed in flight.
+    [[nodiscard]] virtual auto window() const -> size_t = 0;
+};
+
+/// Loss-based congestion control with slow start, additive increase and
+/// multiplicative decrease (RFC 5681).
+class AimdController : public CongestionController {
+public:
+    static auto create() -> AimdController {
+        return {};
+    }
+
+    void reset(size_t mss) override {
+        this->mss = mss;
+        cwnd = INITIAL_WINDOW * mss;
+        ssthresh = SIZE_MAX;
+        increase = 0;
+    }
+
+    void acknowledged(size_t acked, size_t in_flight, uint64_t rtt) override {
+        if (cwnd < ssthresh) {
+            // slow start, the window grows by up to one segment per ACK
+            cwnd += (acked < mss) ? acked : mss;
+            return;
+        }
+
+        // congestion avoidance, the window grows by one segment per window
+        increase += acked;
+
+        if (increase >= cwnd) {
+            increase -= cwnd;
+            cwnd += mss;
+        }
+    }
+
+    void lost(size_t in_flight) override {
+        ssthresh = threshold(in_flight);
+        cwnd = ssthresh;
+        increase = 0;
+    }
+
+    void timed_out(size_t in_flight) override {
+        ssthresh = threshold(in_flight);
+        cwnd = mss;
+        increase = 0;
+    }
+
+    [[nodiscard]] auto window() const -> size_t override {
+        return cwnd;
+    }
+
+private:
+    AimdController() = default;
+
+    [[nodiscard]] auto threshold(size_t in_flight) const -> size_t {
+        return (in_flight / 2 > 2 * mss) ? in_flight / 2 : 2 * mss;
+    }
+
+    static constexpr size_t INITIAL_WINDOW = 4;
+
+    size_t mss{1};
+    size_t cwnd{INITIAL_WINDOW};
+    size_t ssthresh{SIZE_MAX};
+
+    // acknowledged data since the last increase in congestion avoidance
+    size_t increase{};
+};
+
+/// Delay-based congestion control. The controller compares each round-trip
+/// time sample with the smallest one seen, i.e., the round-trip time of the
+/// path without queueing, and estimates the data the connection keeps
+/// queued along the path. The window grows while less than `ALPHA` segments
+/// are queued and shrinks once more than `BETA` segments are queued, such
+/// that connections sharing a link keep its queue short (TCP Vegas).
+class DelayController : public CongestionController {
+public:
+    static auto create() -> DelayController {
+        return {};
+    }
+
+    void reset(size_t mss) override {
+        this->mss = mss;
+        cwnd = INITIAL_WINDOW * mss;
+        base_rtt = 0;
+    }
+
+    void acknowledged(size_t acked, size_t in_flight, uint64_t rtt) override {
+        // the window is adjusted once per round trip, i.e., per sample
+        if (rtt == 0) {
+            return;
+        }
+
+        if (base_rtt == 0 || rtt < base_rtt) {
+            base_rtt = rtt;
+        }
+
+        // data in flight beyond the bandwidth-delay product of the path
+        auto queued = cwnd * (rtt - base_rtt) / rtt;
+
+        if (queued < ALPHA * mss) {
+            cwnd += mss;
+        } else if (queued > BETA * mss && cwnd > 2 * mss) {
+            cwnd -= mss;
+        }
+    }
+
+    void lost(size_t in_flight) override {
+        cwnd = cwnd * 3 / 4;
+        cwnd = (cwnd > 2 * mss) ? cwnd : 2 * mss;
+    }
+
+    void timed_out(size_t in_flight) override {
+        cwnd = 2 * mss;
+    }
+
+    [[nodiscard]] auto window() const -> size_t override {
+        return cwnd;
+    }
+
+    /// Returns the smallest round-trip time seen (ms).
+    [[nodiscard]] auto min_rtt() const -> uint64_t {
+        return base_rtt;
+    }
+
+private:
+    DelayController() = default;
+
+    static constexpr size_t INITIAL_WINDOW = 4;
+    static constexpr size_t ALPHA = 2;
+    static constexpr size_t BETA = 4;
+
+    size_t mss{1};
+    size_t cwnd{INITIAL_WINDOW};
+
+    uint64_t base_rtt{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_CONGESTION_HPP
@@ -1,23 +1,31 @@
 #ifndef SPACE_TCP_CONNECTION_HPP
 #define SPACE_TCP_CONNECTION_HPP
 
+#include "space_tcp/config.hpp"
+#include "space_tcp/congestion.hpp"
+#include "space_tcp/fec.hpp"
+#include "space_tcp/fountain.hpp"
+#include "space_tcp/list.hpp"
 #include "space_tcp/log.hpp"
+#include "space_tcp/pacing.hpp"
 #include "space_tcp/rand.hpp"
 #include "space_tcp/time.hpp"
 #include "space_tcp/ring.hpp"
 #include "space_tcp/segment.hpp"
+#include "space_tcp/sequence.hpp"
+#include "space_tcp/timer.hpp"
 
-#include <unistd.h>
-
-#define WINDOWSIZE 32
-
-// retransmit missing messages after this time (ms)
-#define RETRANSMISSION_TIMEOUT 100
+#include <atomic>
 
+#include <unistd.h>
 
 namespace space_tcp {
 
-class TcpEndpoint;
+template<typename Config>
+class BasicTcpEndpoint;
+
+template<typename Config>
+class CoroutineOperation;
 
 /// Connection states.
 enum class State {
@@ -40,18 +48,43 @@ enum class State {
     CloseWait,
     /// Connection closed after remote host closed it already.
     LastAck,
+    /// Unidirectional transfer of a fountain-coded object, without handshake
+    /// and acknowledgments.
+    Fountain,
 };
 
-/// A S3TP connection.
-class Connection {
-    template<typename std::size_t S>
+/// A S3TP connection of an endpoint configured by `Config`.
+///
+/// Connections may be used from one application thread while another thread
+/// drives the endpoint: send(), reserve() and commit() fill the transmit
+/// buffer, receive(), peek() and consume() drain the receive buffer, both
+/// lock-free single-producer/single-consumer queues, and the endpoint picks
+/// up the changes through a lock-free inbox. All other calls belong to the
+/// thread driving the endpoint.
+template<typename Config>
+class BasicConnection {
+    template<typename std::size_t S, typename C>
     friend
     class Connections;
 
-    friend class TcpEndpoint;
+    template<typename C>
+    friend
+    class BasicSlabConnections;
+
+    template<typename C, typename std::size_t S>
+    friend
+    class BasicEndpointRunner;
+
+    template<typename C>
+    friend
+    class BasicCoroutineExecutor;
+
+    friend class BasicTcpEndpoint<Config>;
+
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
 
 public:
-    ~Connection() = default;
+    ~BasicConnection() = default;
 
     /// Receive method of connection. Copies previously received data from the
     /// connection receive buffer to `buffer`.
@@ -67,7 +100,45 @@ public:
         len = (len) ? len : T;
         len = (len < available_data) ? len : available_data;
 
-        return receive_buffer.pop_front(buffer, len);
+        auto received = receive_buffer.pop_front(buffer, len);
+
+        // the endpoint updates the window of the remote host
+        notify_endpoint();
+
+        return received;
+    }
+
+    /// Receive method of connection for scattered buffers. Copies previously
+    /// received data to the `count` `regions` in order. Returns the bytes
+    /// copied.
+    auto receive(const region *regions, size_t count) -> ssize_t {
+        ssize_t received = 0;
+
+        for (size_t i = 0; i < count && !receive_buffer.empty(); i++) {
+            received += receive_buffer.pop_front(regions[i].data, regions[i].len);
+        }
+
+        notify_endpoint();
+
+        return received;
+    }
+
+    /// Stores the received data in `regions` without copying it, data
+    /// wrapping around the end of the receive buffer is split into two
+    /// regions. The regions stay valid until consume() releases them.
+    /// Returns the bytes stored.
+    auto peek(const_region (&regions)[2]) const -> size_t {
+        return receive_buffer.readable(regions);
+    }
+
+    /// Releases `len` bytes of the received data returned by peek(). Returns
+    /// the bytes released.
+    auto consume(size_t len) -> size_t {
+        auto consumed = receive_buffer.pop_front(nullptr, len);
+
+        notify_endpoint();
+
+        return consumed;
     }
 
     /// Send method of connection. Copies data to be sent to the connection
@@ -81,7 +152,48 @@ public:
 
         len = (len) ? len : T;
 
-        return transmit_buffer.push_back(buffer, len);
+        auto pushed = transmit_buffer.push_back(buffer, len);
+
+        notify_endpoint();
+
+        return pushed;
+    }
+
+    /// Send method of connection for gathered data. Copies the `count`
+    /// `regions` in order to the connection transmit buffer as far as it has
+    /// free space. Returns the bytes copied.
+    auto send(const const_region *regions, size_t count) -> ssize_t {
+        ssize_t pushed = 0;
+
+        for (size_t i = 0; i < count && transmit_buffer.free_space() > 0; i++) {
+            if (regions[i].len > 0) {
+                pushed += transmit_buffer.push_back(regions[i].data, regions[i].len);
+            }
+        }
+
+        notify_endpoint();
+
+        return pushed;
+    }
+
+    /// Stores up to `len` bytes of free space of the transmit buffer in
+    /// `regions`, space wrapping around the end of the buffer is split into
+    /// two regions. Data written to the regions is sent once commit() adds
+    /// it to the buffer. Returns the bytes stored.
+    auto reserve(size_t len, region (&regions)[2]) -> size_t {
+        return transmit_buffer.writable(regions, len);
+    }
+
+    /// Sends the first `len` bytes written to the regions returned by
+    /// reserve(). Returns false if `len` exceeds the free space.
+    auto commit(size_t len) -> bool {
+        if (!transmit_buffer.advance_head(len)) {
+            return false;
+        }
+
+        notify_endpoint();
+
+        return true;
     }
 
     /// Sets the state of the connection to `Listen` such that incoming data is
@@ -90,10 +202,72 @@ public:
         state = State::Listen;
     }
 
+    /// Opens the connection to the remote host right away, i.e., without
+    /// waiting for data to send. Connections open on their own once data is
+    /// sent, too.
+    auto connect() {
+        if (state != State::Closed) {
+            return;
+        }
+
+        connect_requested = true;
+
+        notify_endpoint();
+    }
+
+    /// Streams symbols of the object of `encoder` to the remote host, which
+    /// rebuilds the object once enough symbols arrived, see receive_object().
+    /// The transfer needs no handshake and no ACKs, i.e., it works on links
+    /// without a return channel. It ends after `symbols` symbols, on feedback
+    /// from the remote host or on close(); 0 symbols send until feedback or
+    /// close(). The connection has to be closed and the encoder has to outlive
+    /// the transfer. Returns whether the transfer started, objects exceeding
+    /// FOUNTAIN_MAX_BLOCKS symbols are not sent.
+    auto send_object(FountainEncoder *encoder, size_t symbols = 0) -> bool {
+        if (state != State::Closed || !encoder || encoder->blocks() == 0) {
+            warn("fountain transfers need a closed connection and a non-empty object of at most "
+                 << FOUNTAIN_MAX_BLOCKS << " symbols");
+            return false;
+        }
+
+        state = State::Fountain;
+        fountain_encoder = encoder;
+        fountain_symbol = 0;
+        fountain_symbols_left = symbols ? symbols : SIZE_MAX;
+
+        notify_endpoint();
+
+        return true;
+    }
+
+    /// Rebuilds an object sent with send_object() by the remote host in
+    /// `decoder`. With `feedback`, the connection tells the remote host to
+    /// stop sending once the object is complete. The decoder has to outlive
+    /// the transfer, close() ends it.
+    auto receive_object(FountainDecoder *decoder, bool feedback = true) -> bool {
+        if ((state != State::Closed && state != State::Listen) || !decoder) {
+            warn("fountain transfers need a closed connection");
+            return false;
+        }
+
+        state = State::Fountain;
+        fountain_decoder = decoder;
+        fountain_feedback = feedback;
+
+        return true;
+    }
+
     /// Sets the state of the connection to `FinWait` such that the connection
-    /// will be closed by the endpoint.
+    /// will be closed by the endpoint. Fountain transfers end right away.
     auto close() {
+        if (state == State::Fountain) {
+            end_fountain();
+            return;
+        }
+
         state = State::Closing;
+
+        notify_endpoint();
     }
 
     /// Returns the state of the connection.
@@ -113,14 +287,118 @@ public:
         return transmit_buffer.empty();
     }
 
+    /// Returns the largest payload sent in a single packet of this connection.
+    /// The size is agreed with the remote host when opening the connection.
+    [[nodiscard]] auto segment_size() const -> size_t {
+        return mss;
+    }
+
+    /// Returns the smoothed round-trip time of the connection (ms), 0 until
+    /// the first round-trip time has been measured.
+    [[nodiscard]] auto rtt() const -> uint64_t {
+        return srtt;
+    }
+
+    /// Returns the variation of the round-trip time of the connection (ms).
+    [[nodiscard]] auto rtt_variation() const -> uint64_t {
+        return rttvar;
+    }
+
+    /// Returns the time after which unacknowledged data is retransmitted (ms).
+    [[nodiscard]] auto retransmission_timeout() const -> uint64_t {
+        return rto;
+    }
+
+    /// Limits the rate (bytes per second) at which the connection sends
+    /// packets, on top of the rate of the network. A rate of 0 removes the
+    /// limit.
+    auto set_rate(uint64_t rate) {
+        pacer = TokenBucket::create(rate, Config::PACING_BURST * mss);
+
+        notify_endpoint();
+    }
+
+    /// Returns the rate limit of the connection (bytes per second), 0 if the
+    /// connection is not paced.
+    [[nodiscard]] auto rate() const -> uint64_t {
+        return pacer.get_rate();
+    }
+
+    /// Makes `controller` limit the data in flight of this connection, see
+    /// AimdController and DelayController. Without a controller, the static
+    /// window of the configuration applies. The controller has to outlive the
+    /// connection, `nullptr` removes it.
+    auto set_congestion_controller(CongestionController *controller) {
+        congestion = controller;
+
+        if (congestion) {
+            congestion->reset(mss);
+        }
+
+        notify_endpoint();
+    }
+
+    /// Makes `fec` protect the data of this connection with repair packets,
+    /// see ForwardErrorCorrection. The remote host needs an instance, too, to
+    /// rebuild lost segments. The instance has to outlive the connection,
+    /// `nullptr` removes it.
+    auto set_forward_error_correction(ForwardErrorCorrection *fec) {
+        this->fec = fec;
+
+        notify_endpoint();
+    }
+
+    /// Requests 32-bit sequence numbers on the wire for this connection. The
+    /// request has to be made before the connection is opened and only takes
+    /// effect if the remote host requests extended sequence numbers, too.
+    auto use_extended_sequence_numbers(bool extended) {
+        extended_seq = extended;
+    }
+
+    /// Returns whether the connection uses (or requests) 32-bit sequence
+    /// numbers on the wire.
+    [[nodiscard]] auto extended_sequence_numbers() const -> bool {
+        return extended_seq;
+    }
+
+    /// Announces header options such as the receive window and selective
+    /// acknowledgments for this connection. Options are on by default and
+    /// only sent after both hosts announced them in the SYN and SYN+ACK,
+    /// i.e., hosts which do not know header options never receive them.
+    /// Turning them off before the connection is opened makes it behave
+    /// like such a host.
+    auto use_header_options(bool use) {
+        options = use;
+    }
+
+    /// Returns whether the connection uses (or announces) header options.
+    [[nodiscard]] auto header_options() const -> bool {
+        return options;
+    }
+
+    /// Requests compressed payloads for this connection, see LzCompressor.
+    /// The request has to be made before the connection is opened and only
+    /// takes effect if the remote host requests compression, too.
+    auto use_compression(bool compress) {
+        compression = compress;
+    }
+
+    /// Returns whether the connection compresses (or requests to compress)
+    /// its payloads.
+    [[nodiscard]] auto compressed() const -> bool {
+        return compression;
+    }
+
 private:
-    Connection(uint8_t *buffer, size_t len, uint16_t src_port, uint16_t dst_port, TcpEndpoint &endpoint) : src_port{src_port}, dst_port{dst_port}, endpoint{endpoint} {
-        if (len < 512 * 4) {
-            error("connection buffer size must be at least 4 S3TP packet payload size, i.e., 2048 B");
+    BasicConnection(uint8_t *buffer, size_t len, uint16_t src_port, uint16_t dst_port, TcpEndpoint &endpoint) : src_port{src_port}, dst_port{dst_port}, endpoint{endpoint} {
+        if (len < Config::PAYLOAD_SIZE * 4) {
+            error("connection buffer size must be at least 4 S3TP packet payload size, i.e., " << Config::PAYLOAD_SIZE * 4 << " B");
         }
 
-        receive_buffer = RingBuffer::create(buffer, len/2);
-        transmit_buffer = RingBuffer::create(buffer + len/2, len/2);
+        auto rx_len = len * Config::RX_BUFFER_SHARE / 100;
+
+        receive_buffer = RingBuffer::create(buffer, rx_len);
+        transmit_buffer = RingBuffer::create(buffer + rx_len, len - rx_len);
 
         auto tx = Rng::generate_random_number(0, 0x0100);
         tx_next_seq_num = tx;
@@ -128,10 +406,44 @@ private:
         tx_unacked = tx;
     };
 
+    /// Tells the remote host that the receive window opened once it grew by a
+    /// segment or half the buffer, smaller updates would only invite small
+    /// segments (RFC 1122). Called by the endpoint after the application
+    /// read data.
+    void window_opened() {
+        auto threshold = (mss < receive_buffer.capacity() / 2) ? mss : receive_buffer.capacity() / 2;
+        auto window = receive_buffer.free_space();
+
+        if (state == State::Established && rx_advertised < window && window - rx_advertised >= threshold) {
+            ack_delayed = true;
+            ack_deadline = 0;
+        }
+    }
+
+    /// Ends a fountain transfer.
+    void end_fountain() {
+        state = State::Closed;
+        fountain_encoder = nullptr;
+        fountain_decoder = nullptr;
+
+        notify_endpoint();
+    }
+
     /// Returns whether the TX timer for this connection has expired, i.e.,
     /// data has to be re-sent.
     [[nodiscard]] auto tx_timer_expired(size_t time) const -> bool {
-        return (tx_unacked != tx_next_seq_num) && (tx_last_time + RETRANSMISSION_TIMEOUT) < time;
+        return (tx_unacked != tx_next_seq_num) && tx_last_time + rto <= time;
+    }
+
+    /// Returns whether the ACK for received data is due.
+    [[nodiscard]] auto ack_timer_expired(size_t time) const -> bool {
+        return ack_delayed && ack_deadline <= time;
+    }
+
+    /// Records that all data received so far is acknowledged.
+    void ack_sent() {
+        ack_delayed = false;
+        rx_unacked_segments = 0;
     }
 
     /// Returns the amount of data that has not been acknowledged yet.
@@ -146,10 +458,126 @@ private:
     }
 
     /// Returns whether the TX buffer contains unsent data.
-    auto tx_data_to_send() -> bool {
+    [[nodiscard]] auto tx_data_to_send() const -> bool {
         return tx_data_in_flight() < transmit_buffer.used_space();
     }
 
+    /// Returns whether the remote host has no room for data to send, i.e.,
+    /// the window has to be probed on expiry of the TX timer.
+    [[nodiscard]] auto tx_window_closed() const -> bool {
+        return state == State::Established && tx_remote_window == 0 && tx_unacked == tx_next_seq_num &&
+               tx_data_to_send();
+    }
+
+    /// Returns whether the TX timer of this connection is running, i.e., the
+    /// connection waits for the acknowledgment of a transmitted packet or
+    /// delays the acknowledgment of received data.
+    [[nodiscard]] auto tx_timer_running() const -> bool {
+        if (ack_delayed || tx_window_closed()) {
+            return true;
+        }
+
+        switch (state) {
+            case State::Closed:
+            case State::Listen:
+            case State::Closing:
+            case State::CloseWait:
+            case State::Fountain:
+                return false;
+            default:
+                return tx_unacked != tx_next_seq_num;
+        }
+    }
+
+    /// Returns the time at which the TX timer of this connection expires,
+    /// i.e., data has to be re-sent or the delayed ACK is due.
+    [[nodiscard]] auto tx_timer_deadline() const -> uint64_t {
+        auto deadline = UINT64_MAX;
+
+        if (tx_unacked != tx_next_seq_num || tx_window_closed()) {
+            deadline = tx_last_time + rto;
+        }
+
+        if (ack_delayed && ack_deadline < deadline) {
+            deadline = ack_deadline;
+        }
+
+        return deadline;
+    }
+
+    /// Starts measuring the round-trip time of the data up to `seq_num` sent
+    /// at `time` unless a measurement is running already.
+    void rtt_start(uint32_t seq_num, uint64_t time) {
+        if (rtt_timing) {
+            return;
+        }
+
+        rtt_timing = true;
+        rtt_seq_num = seq_num;
+        rtt_time = time;
+    }
+
+    /// Stops measuring the round-trip time since data was retransmitted and
+    /// its ACK cannot be attributed to either transmission (Karn's rule).
+    void rtt_cancel() {
+        rtt_timing = false;
+    }
+
+    /// Updates the round-trip time estimates if `ack_num` received at `time`
+    /// acknowledges the measured data (RFC 6298). Returns the round-trip time
+    /// sample (ms, at least 1), 0 if the ACK gives no sample.
+    auto rtt_acknowledged(uint32_t ack_num, uint64_t time) -> uint64_t {
+        if (!rtt_timing || seq_lt(ack_num, rtt_seq_num)) {
+            return 0;
+        }
+
+        rtt_timing = false;
+
+        auto sample = time - rtt_time;
+
+        if (!rtt_measured) {
+            rtt_measured = true;
+            srtt = sample;
+            rttvar = sample / 2;
+        } else {
+            auto deviation = (srtt > sample) ? srtt - sample : sample - srtt;
+            rttvar = (3 * rttvar + deviation) / 4;
+            srtt = (7 * srtt + sample) / 8;
+        }
+
+        // clock granularity is 1 ms
+        rto = srtt + ((4 * rttvar > 1) ? 4 * rttvar : 1);
+        rto = (rto < Config::MIN_RETRANSMISSION_TIMEOUT) ? Config::MIN_RETRANSMISSION_TIMEOUT : rto;
+        rto = (rto > Config::MAX_RETRANSMISSION_TIMEOUT) ? Config::MAX_RETRANSMISSION_TIMEOUT : rto;
+
+        return (sample > 0) ? sample : 1;
+    }
+
+    /// Doubles the retransmission timeout after expiry of the TX timer.
+    void rto_back_off() {
+        rto = (2 * rto < Config::MAX_RETRANSMISSION_TIMEOUT) ? 2 * rto : Config::MAX_RETRANSMISSION_TIMEOUT;
+    }
+
+    /// Returns whether the connection retransmits data reported missing.
+    [[nodiscard]] auto tx_retransmitting() const -> bool {
+        return seq_lt(tx_rtx_next, tx_rtx_end);
+    }
+
+    /// Returns the amount of data in flight the remote host reported as
+    /// received.
+    [[nodiscard]] auto tx_sacked_data() const -> size_t {
+        size_t sacked = 0;
+
+        for (size_t i = 0; i < tx_sacked_count; i++) {
+            sacked += tx_sacked[i].end - tx_sacked[i].start;
+        }
+
+        return sacked;
+    }
+
+    /// Tells the endpoint that the connection may have something to transmit.
+    void notify_endpoint();
+
     // connection properties
     uint16_t src_port;
     uint16_t dst_port;
@@ -157,31 +585,117 @@ private:
     // connection state
     State state{State::Closed};
 
+    // SYN to be sent even without data, see connect()
+    bool connect_requested{};
+
+    // 32-bit sequence numbers on the wire
+    bool extended_seq{};
+
+    // header options beyond the SYN, only if both hosts announce them
+    bool options{true};
+
+    // compressed payloads, segments are sent uncompressed while compress_skip
+    // is non-zero after data did not shrink
+    bool compression{};
+    size_t compress_skip{};
+
+    // maximum segment size, i.e., largest payload sent to the remote host
+    size_t mss{Config::PAYLOAD_SIZE};
+
     RingBuffer receive_buffer = RingBuffer::create(nullptr, 0);
     RingBuffer transmit_buffer = RingBuffer::create(nullptr, 0);
 
-    // TX connection information
-    uint16_t tx_next_seq_num;
-    uint16_t tx_initial_seq_num;
-    uint16_t tx_unacked;                // oldest unacknowledged sequence number of transmitted packets
+    // TX connection information, sequence numbers are 32 bit internally and
+    // truncated to 16 bit on the wire unless extended sequence numbers are used
+    uint32_t tx_next_seq_num;
+    uint32_t tx_initial_seq_num;
+    uint32_t tx_unacked;                // oldest unacknowledged sequence number of transmitted packets
     uint64_t tx_last_time{};
     size_t sent_bytes{};                // unacknowledged data ?
 
+    // ranges beyond tx_unacked the remote host reported as received (SACK)
+    seq_range tx_sacked[MAX_SACK_BLOCKS]{};
+    size_t tx_sacked_count{};
+
+    // missing data in [tx_rtx_next, tx_rtx_end) is retransmitted
+    uint32_t tx_rtx_next{};
+    uint32_t tx_rtx_end{};
+
+    // round-trip time estimates (ms) and retransmission timeout
+    uint64_t srtt{};
+    uint64_t rttvar{};
+    uint64_t rto{Config::RETRANSMISSION_TIMEOUT};
+    bool rtt_measured{};
+
+    // data up to rtt_seq_num sent at rtt_time is timed for a round-trip time sample
+    bool rtt_timing{};
+    uint32_t rtt_seq_num{};
+    uint64_t rtt_time{};
+
+    // receive window advertised by the remote host, unknown until it sends one
+    size_t tx_remote_window{SIZE_MAX};
+
+    // limits data in flight below the static window if set
+    CongestionController *congestion{};
+
+    // sends and receives repair packets if set
+    ForwardErrorCorrection *fec{};
+
+    // fountain transfer, either sending or receiving an object
+    FountainEncoder *fountain_encoder{};
+    FountainDecoder *fountain_decoder{};
+    uint32_t fountain_symbol{};         // id of the next symbol to send
+    size_t fountain_symbols_left{};
+    bool fountain_feedback{};
+
+    // spaces packets of this connection
+    TokenBucket pacer = TokenBucket::create(0, 0);
+
+    // ACKs repeating tx_unacked while data is in flight
+    size_t tx_dup_acks{};
+    bool tx_fast_retransmitted{};       // since the last new ACK
+
     // RX connection information
-    uint16_t rx_next_seq_num{};         // next expected sequence number for incoming packets
-    uint16_t rx_initial_seq_num{};
-    uint16_t rx_acked{};                // actually acknowledged sequence number
+    uint32_t rx_next_seq_num{};         // next expected sequence number for incoming packets
+    uint32_t rx_initial_seq_num{};
+    uint32_t rx_acked{};                // actually acknowledged sequence number
     uint64_t rx_last_time{};
     uint16_t received_bytes{};
+    size_t rx_advertised{SIZE_MAX};     // receive window last advertised to the remote host
+    size_t rx_stream_offset{};          // data received in order, i.e., stream offset of rx_next_seq_num
 
     uint64_t close_at{};                // connection will be closed after this time
 
-    // out of order received segments
-    Segments<WINDOWSIZE - 1> ooo_segments;
+    // delayed acknowledgment of received data
+    bool ack_delayed{};
+    uint64_t ack_deadline{};
+    size_t rx_unacked_segments{};       // segments received in order since the last ACK
+
+    // out of order received segments, offsets are stream offsets
+    Segments<Config::WINDOW_SIZE - 1> ooo_segments;
+
+    // links into the ready, timer, ACK and progress queues of the endpoint
+    ListHook<BasicConnection> ready_hook;
+    ListHook<BasicConnection> timer_hook;
+    TimerEntry timer_entry;
+    ListHook<BasicConnection> ack_hook;
+    ListHook<BasicConnection> progress_hook;
+
+    // operations of coroutines suspended until the connection makes progress,
+    // linked through the operations, see BasicCoroutineExecutor
+    CoroutineOperation<Config> *awaiting{};
+
+    // notifications for the endpoint, possibly from another thread, queue the
+    // connection in the inbox of the endpoint once until it is taken
+    std::atomic<bool> notified{};
+    BasicConnection *inbox_next{};
 
     TcpEndpoint &endpoint;
 };
 
+/// A S3TP connection of an endpoint with the default configuration.
+using Connection = BasicConnection<DefaultConfig>;
+
 }  // namespace space_tcp
 
 #endif //SPACE_TCP_CONNECTION_HPP
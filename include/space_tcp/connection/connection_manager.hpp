@@ -1,12 +1,18 @@
 #ifndef SPACE_TCP_CONNECTION_MANAGER_HPP
 #define SPACE_TCP_CONNECTION_MANAGER_HPP
 
+#include "connection.hpp"
+
 namespace space_tcp {
 
-/// Interface for a connection storage.
-class ConnectionManager {
+/// Interface for a storage of connections configured by `Config`.
+template<typename Config>
+class BasicConnectionManager {
 public:
-    virtual ~ConnectionManager() = default;
+    using Connection = BasicConnection<Config>;
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
+
+    virtual ~BasicConnectionManager() = default;
 
     /// Returns the number of stored connections.
     virtual auto stored_connections() -> size_t = 0;
@@ -18,14 +24,70 @@ public:
     /// port. Returns `nullptr` if no such connection exists.
     virtual auto find_connection(uint16_t src_port, uint16_t dst_port) -> Connection * = 0;
 
+    /// Returns whether `connection` is stored, i.e., was created and not
+    /// destroyed since. Does not access the connection, a destroyed
+    /// connection can be passed.
+    virtual auto contains(Connection *connection) -> bool {
+        for (size_t i = 0; i < stored_connections(); i++) {
+            if (get_connection(i) == connection) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     /// Creates a connection in the connection storage.
     virtual auto create_connection(uint8_t *buffer, size_t len, uint8_t rx_port, uint8_t tx_port, TcpEndpoint &endpoint) -> Connection * = 0;
+
+    /// Destroys a connection of the connection storage such that its memory
+    /// can be reused. Returns false if the connection is not stored or the
+    /// storage cannot remove connections.
+    virtual auto destroy_connection(Connection *connection) -> bool {
+        return false;
+    }
 };
 
+/// Interface for a storage of connections with the default configuration.
+using ConnectionManager = BasicConnectionManager<DefaultConfig>;
+
+namespace detail {
+
+// ports of a connection combined into one lookup key
+constexpr auto port_key(uint16_t src_port, uint16_t dst_port) -> uint32_t {
+    return (static_cast<uint32_t>(src_port) << 16) | dst_port;
+}
+
+// number of bits addressing an index of `size` slots, a power of two
+constexpr auto index_bits(size_t size) -> unsigned {
+    unsigned bits = 0;
+
+    while ((size_t{1} << bits) < size) {
+        bits++;
+    }
+
+    return bits;
+}
+
+// slot of `key` in an index of 2^`bits` slots. Fibonacci hashing of the port
+// key, the top bits of the product are the best mixed ones
+constexpr auto hash(uint32_t key, unsigned bits) -> size_t {
+    return (bits == 0) ? 0 : static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+}  // namespace detail
+
 /// Concrete implementation of connection storage. Stores `S` connections in its memory.
-template<typename std::size_t S>
-class alignas(Connection) Connections : public ConnectionManager {
+///
+/// Connections are looked up by their ports. Small storages compare the ports
+/// of all connections, larger storages keep an open addressing hash index
+/// next to the connections.
+template<typename std::size_t S, typename Config = DefaultConfig>
+class alignas(BasicConnection<Config>) Connections final : public BasicConnectionManager<Config> {
 public:
+    using Connection = BasicConnection<Config>;
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
+
     ~Connections() override {
         for (size_t i = 0; i < num_connections; i++) {
             (reinterpret_cast<Connection *>(connections) + i)->~Connection();
@@ -45,15 +107,30 @@ public:
     }
 
     auto find_connection(uint16_t src_port, uint16_t dst_port) -> Connection * override {
-        for (size_t i = 0; i < num_connections; i++) {
-            auto connection = get_connection(i);
+        auto key = detail::port_key(src_port, dst_port);
 
-            if (connection->src_port == src_port && connection->dst_port == dst_port) {
-                return connection;
+        if constexpr (LINEAR_LOOKUP) {
+            // compare all keys, the compiler turns this into conditional moves
+            auto found = S;
+
+            for (size_t i = 0; i < S; i++) {
+                found = (keys[i] == key && i < num_connections && found == S) ? i : found;
             }
-        }
 
-        return nullptr;
+            return (found < S) ? reinterpret_cast<Connection *>(connections) + found : nullptr;
+        } else {
+            for (auto slot = detail::hash(key, INDEX_BITS);; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+                auto i = index[slot];
+
+                if (i == 0) {
+                    return nullptr;
+                }
+
+                if (keys[i - 1] == key) {
+                    return reinterpret_cast<Connection *>(connections) + i - 1;
+                }
+            }
+        }
     }
 
     auto create_connection(uint8_t *buffer, size_t len, uint8_t rx_port, uint8_t tx_port,
@@ -62,13 +139,51 @@ public:
             error("cannot create new connection: maximum number of specified connections was already created");
         }
 
+        auto key = detail::port_key(rx_port, tx_port);
+
+        if constexpr (!LINEAR_LOOKUP) {
+            auto slot = detail::hash(key, INDEX_BITS);
+
+            while (index[slot] != 0) {
+                slot = (slot + 1) & (INDEX_SIZE - 1);
+            }
+
+            index[slot] = num_connections + 1;
+        }
+
+        keys[num_connections] = key;
+
         return new(reinterpret_cast<Connection *>(connections) + num_connections++) Connection(buffer, len, rx_port,
                                                                                                tx_port, endpoint);
     }
 
 private:
-    uint8_t connections[S * sizeof(Connection)]{};
+    // storages up to this size are searched linearly
+    static constexpr bool LINEAR_LOOKUP = S <= 8;
+
+    // power of two with a load factor of at most 1/2
+    static constexpr auto index_size() -> size_t {
+        size_t size = 1;
+
+        while (size < 2 * S) {
+            size <<= 1;
+        }
+
+        return size;
+    }
+
+    static constexpr size_t INDEX_SIZE = LINEAR_LOOKUP ? 1 : index_size();
+
+    static constexpr unsigned INDEX_BITS = detail::index_bits(INDEX_SIZE);
+
+    alignas(Connection) uint8_t connections[S * sizeof(Connection)]{};
     size_t num_connections{};
+
+    // ports of the stored connections
+    uint32_t keys[S]{};
+
+    // hash index: number of the connection + 1, 0 for empty slots
+    uint32_t index[INDEX_SIZE]{};
 };
 
 }  // namespace space_tcp
@@ -0,0 +1,265 @@
+#ifndef SPACE_TCP_SLAB_CONNECTIONS_HPP
+#define SPACE_TCP_SLAB_CONNECTIONS_HPP
+
+#include "connection.hpp"
+#include "connection_manager.hpp"
+
+#include <new>
+
+namespace space_tcp {
+
+/// Growable implementation of connection storage. Connections live in slabs
+/// of page-sized chunks which are allocated on demand, destroyed connections
+/// go to a free list and their slots are reused. Connections never move, i.e.,
+/// pointers to connections stay valid until they are destroyed. Slots know
+/// whether they hold a connection, i.e., destroying a connection twice is
+/// detected without accessing the destroyed connection.
+template<typename Config>
+class BasicSlabConnections final : public BasicConnectionManager<Config> {
+public:
+    using Connection = BasicConnection<Config>;
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
+
+    BasicSlabConnections() = default;
+
+    BasicSlabConnections(const BasicSlabConnections &) = delete;
+
+    auto operator=(const BasicSlabConnections &) -> BasicSlabConnections & = delete;
+
+    ~BasicSlabConnections() override {
+        for (size_t i = 0; i < num_connections; i++) {
+            live[i]->~Connection();
+        }
+
+        while (chunks) {
+            auto chunk = chunks;
+            chunks = chunk->next;
+            ::operator delete(chunk, std::align_val_t{alignof(Chunk)});
+        }
+
+        delete[] live;
+        delete[] index;
+    }
+
+    auto stored_connections() -> size_t override {
+        return num_connections;
+    }
+
+    auto get_connection(size_t i) -> Connection * override {
+        if (num_connections <= i) {
+            error("cannot access connection " << i + 1 << " out of " << num_connections << " connections");
+        }
+
+        return live[i];
+    }
+
+    auto find_connection(uint16_t src_port, uint16_t dst_port) -> Connection * override {
+        if (index_size == 0) {
+            return nullptr;
+        }
+
+        for (auto slot = hash(src_port, dst_port);; slot = (slot + 1) & (index_size - 1)) {
+            auto connection = index[slot];
+
+            if (!connection) {
+                return nullptr;
+            }
+
+            if (connection->src_port == src_port && connection->dst_port == dst_port) {
+                return connection;
+            }
+        }
+    }
+
+    /// Returns whether `connection` is stored. `connection` has to be a
+    /// connection created by this storage.
+    auto contains(Connection *connection) -> bool override {
+        return slot_of(connection)->live;
+    }
+
+    auto create_connection(uint8_t *buffer, size_t len, uint8_t rx_port, uint8_t tx_port,
+                           TcpEndpoint &endpoint) -> Connection * override {
+        if (find_connection(rx_port, tx_port)) {
+            error("cannot create new connection: a connection with ports " << +rx_port << "/" << +tx_port
+                                                                            << " exists already");
+        }
+
+        if (!free_slots) {
+            grow_slab();
+        }
+
+        if (num_connections == live_size) {
+            grow_live();
+        }
+
+        if (2 * (num_connections + 1) > index_size) {
+            grow_index();
+        }
+
+        auto slot = free_slots;
+        free_slots = slot->next_free;
+
+        auto connection = new(slot->storage) Connection(buffer, len, rx_port, tx_port, endpoint);
+
+        slot->live = true;
+        slot->live_index = num_connections;
+        live[num_connections++] = connection;
+
+        insert_index(connection);
+
+        return connection;
+    }
+
+    auto destroy_connection(Connection *connection) -> bool override {
+        auto slot = slot_of(connection);
+
+        if (!slot->live) {
+            return false;
+        }
+
+        remove_index(connection);
+
+        // move last connection into the gap of the dense connection list
+        auto last = live[--num_connections];
+
+        live[slot->live_index] = last;
+        slot_of(last)->live_index = slot->live_index;
+
+        connection->~Connection();
+
+        slot->live = false;
+        slot->next_free = free_slots;
+        free_slots = slot;
+
+        return true;
+    }
+
+private:
+    // slot of a connection in a slab chunk
+    struct Slot {
+        alignas(Connection) uint8_t storage[sizeof(Connection)];
+        bool live;
+        size_t live_index;
+        Slot *next_free;
+    };
+
+    // header of a slab chunk, followed by the slots
+    struct alignas(Slot) Chunk {
+        Chunk *next;
+    };
+
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    // chunks span as many pages as needed for at least one slot
+    static constexpr size_t CHUNK_SIZE =
+            (sizeof(Chunk) + sizeof(Slot) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+
+    static constexpr size_t SLOTS_PER_CHUNK = (CHUNK_SIZE - sizeof(Chunk)) / sizeof(Slot);
+
+    static auto slot_of(Connection *connection) -> Slot * {
+        return reinterpret_cast<Slot *>(connection);
+    }
+
+    auto hash(uint16_t src_port, uint16_t dst_port) const -> size_t {
+        return detail::hash(detail::port_key(src_port, dst_port), index_bits);
+    }
+
+    void grow_slab() {
+        // connections keep the state of their ring buffers on separate cache lines
+        auto chunk = static_cast<Chunk *>(::operator new(CHUNK_SIZE, std::align_val_t{alignof(Chunk)}));
+
+        chunk->next = chunks;
+        chunks = chunk;
+
+        auto slots = reinterpret_cast<Slot *>(chunk + 1);
+
+        for (size_t i = 0; i < SLOTS_PER_CHUNK; i++) {
+            slots[i].live = false;
+            slots[i].next_free = free_slots;
+            free_slots = &slots[i];
+        }
+    }
+
+    void grow_live() {
+        auto size = live_size ? 2 * live_size : SLOTS_PER_CHUNK;
+        auto grown = new Connection *[size];
+
+        for (size_t i = 0; i < num_connections; i++) {
+            grown[i] = live[i];
+        }
+
+        delete[] live;
+
+        live = grown;
+        live_size = size;
+    }
+
+    void grow_index() {
+        auto old_index = index;
+        auto old_size = index_size;
+
+        index_size = old_size ? 2 * old_size : 16;
+        index_bits = detail::index_bits(index_size);
+        index = new Connection *[index_size]();
+
+        for (size_t i = 0; i < old_size; i++) {
+            if (old_index[i]) {
+                insert_index(old_index[i]);
+            }
+        }
+
+        delete[] old_index;
+    }
+
+    void insert_index(Connection *connection) {
+        auto slot = hash(connection->src_port, connection->dst_port);
+
+        while (index[slot]) {
+            slot = (slot + 1) & (index_size - 1);
+        }
+
+        index[slot] = connection;
+    }
+
+    void remove_index(Connection *connection) {
+        auto mask = index_size - 1;
+        auto slot = hash(connection->src_port, connection->dst_port);
+
+        while (index[slot] != connection) {
+            slot = (slot + 1) & mask;
+        }
+
+        // backward shift deletion keeps probe sequences free of tombstones
+        for (auto next = (slot + 1) & mask; index[next]; next = (next + 1) & mask) {
+            auto home = hash(index[next]->src_port, index[next]->dst_port);
+
+            // move entry into the gap unless its home lies in (slot, next]
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                index[slot] = index[next];
+                slot = next;
+            }
+        }
+
+        index[slot] = nullptr;
+    }
+
+    Chunk *chunks{};
+    Slot *free_slots{};
+
+    // dense list of stored connections
+    Connection **live{};
+    size_t live_size{};
+    size_t num_connections{};
+
+    // open addressing hash index of stored connections
+    Connection **index{};
+    size_t index_size{};
+    unsigned index_bits{};
+};
+
+/// Growable storage of connections with the default configuration.
+using SlabConnections = BasicSlabConnections<DefaultConfig>;
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_SLAB_CONNECTIONS_HPP
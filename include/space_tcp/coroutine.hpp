@@ -0,0 +1,365 @@
+#ifndef SPACE_TCP_COROUTINE_HPP
+#define SPACE_TCP_COROUTINE_HPP
+
+#include "endpoint.hpp"
+#include "time.hpp"
+
+// the library itself is C++17, coroutines are available to C++20 applications
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <exception>
+
+namespace space_tcp {
+
+/// Return type of coroutines running a session on connections, e.g.,
+///
+///     auto session(CoroutineExecutor &executor, Connection &connection) -> Task {
+///         co_await executor.connect(connection);
+///         co_await executor.send(connection, data);
+///         auto len = co_await executor.receive(connection, buffer);
+///         co_await executor.close(connection);
+///     }
+///
+/// Tasks start right away and free their frame once they return. The frame
+/// is the only memory allocated for a session, operations live in it.
+class Task {
+public:
+    struct promise_type {
+        auto get_return_object() -> Task {
+            return {};
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_never {
+            return {};
+        }
+
+        auto final_suspend() noexcept -> std::suspend_never {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+};
+
+template<typename Config>
+class BasicCoroutineExecutor;
+
+/// Operation on a connection awaited by a coroutine. Operations are returned
+/// by a BasicCoroutineExecutor and awaited right away, i.e., they live in the
+/// frame of the coroutine while it is suspended.
+template<typename Config>
+class CoroutineOperation {
+public:
+    using Connection = BasicConnection<Config>;
+
+    CoroutineOperation(const CoroutineOperation &) = delete;
+    auto operator=(const CoroutineOperation &) -> CoroutineOperation & = delete;
+
+    virtual ~CoroutineOperation() = default;
+
+    void await_suspend(std::coroutine_handle<> coroutine) {
+        handle = coroutine;
+        executor.suspend(*this);
+    }
+
+protected:
+    CoroutineOperation(BasicCoroutineExecutor<Config> &executor, Connection &connection) : executor{executor},
+                                                                                          connection{connection} {}
+
+    /// Makes progress on the operation. Returns whether it completed.
+    virtual auto progress() -> bool = 0;
+
+    BasicCoroutineExecutor<Config> &executor;
+    Connection &connection;
+
+private:
+    friend class BasicCoroutineExecutor<Config>;
+
+    std::coroutine_handle<> handle;
+
+    // next operation suspended on the same connection
+    CoroutineOperation *next_awaiting{};
+};
+
+/// Drives an endpoint configured by `Config` and resumes the coroutines
+/// awaiting operations on its connections once the connections made
+/// progress, i.e., data arrived, the remote host acknowledged data or the
+/// state changed. The endpoint queues the connections which received a
+/// packet or changed their state during tx() and rx(), only operations on
+/// these connections are checked and resuming them allocates no memory.
+template<typename Config>
+class BasicCoroutineExecutor {
+public:
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
+    using Connection = BasicConnection<Config>;
+    using Operation = CoroutineOperation<Config>;
+
+    /// Opens a connection, completes with whether it was established.
+    class ConnectOperation : public Operation {
+    public:
+        ConnectOperation(BasicCoroutineExecutor &executor, Connection &connection) : Operation{executor,
+                                                                                               connection} {}
+
+        auto await_ready() -> bool {
+            this->connection.connect();
+
+            return progress();
+        }
+
+        auto await_resume() -> bool {
+            return this->connection.state == State::Established;
+        }
+
+    protected:
+        auto progress() -> bool override {
+            auto state = this->connection.state;
+
+            if (state == State::Closed) {
+                // a failed attempt falls back to closed
+                return !this->connection.connect_requested && !this->connection.tx_data_to_send();
+            }
+
+            return state != State::SynSent && state != State::SynReceived;
+        }
+    };
+
+    /// Copies data to the transmit buffer of a connection as space frees,
+    /// completes with the bytes copied once all data was copied or the
+    /// connection was closed on this host.
+    class SendOperation : public Operation {
+    public:
+        SendOperation(BasicCoroutineExecutor &executor, Connection &connection, const uint8_t *data,
+                      size_t len) : Operation{executor, connection}, data{data}, len{len} {}
+
+        auto await_ready() -> bool {
+            return progress();
+        }
+
+        auto await_resume() -> ssize_t {
+            return sent;
+        }
+
+    protected:
+        auto progress() -> bool override {
+            auto state = this->connection.state;
+
+            if (state == State::Closing || state == State::FinWait || state == State::TimeWait ||
+                state == State::LastAck) {
+                return true;
+            }
+
+            // a full buffer frees space once the remote host acknowledges data
+            if (this->connection.transmit_buffer.free_space() == 0) {
+                return false;
+            }
+
+            const_region remaining{data + sent, len - sent};
+            sent += this->connection.send(&remaining, 1);
+
+            return sent == len;
+        }
+
+    private:
+        const uint8_t *data;
+        size_t len;
+        size_t sent{};
+    };
+
+    /// Copies received data of a connection, completes with the bytes
+    /// copied once data arrived, or with 0 once no more data can arrive.
+    class ReceiveOperation : public Operation {
+    public:
+        ReceiveOperation(BasicCoroutineExecutor &executor, Connection &connection, uint8_t *buffer,
+                         size_t len) : Operation{executor, connection}, buffer{buffer}, len{len} {}
+
+        auto await_ready() -> bool {
+            return progress();
+        }
+
+        auto await_resume() -> ssize_t {
+            return received;
+        }
+
+    protected:
+        auto progress() -> bool override {
+            if (!this->connection.receive_buffer.empty() || len == 0) {
+                region destination{buffer, len};
+                received = this->connection.receive(&destination, 1);
+
+                return true;
+            }
+
+            auto state = this->connection.state;
+
+            if (state == State::Closed) {
+                // unless the connection is about to open
+                return !this->connection.connect_requested && !this->connection.tx_data_to_send();
+            }
+
+            // the remote host closed the connection
+            return state == State::CloseWait || state == State::LastAck || state == State::TimeWait;
+        }
+
+    private:
+        uint8_t *buffer;
+        size_t len;
+        ssize_t received{};
+    };
+
+    /// Closes a connection, completes once the remote host acknowledged the
+    /// close or the connection is closed.
+    class CloseOperation : public Operation {
+    public:
+        CloseOperation(BasicCoroutineExecutor &executor, Connection &connection) : Operation{executor,
+                                                                                             connection} {}
+
+        auto await_ready() -> bool {
+            auto state = this->connection.state;
+
+            if (state == State::Established || state == State::CloseWait || state == State::Fountain) {
+                this->connection.close();
+            }
+
+            return progress();
+        }
+
+        void await_resume() {}
+
+    protected:
+        auto progress() -> bool override {
+            auto state = this->connection.state;
+
+            return state == State::TimeWait || state == State::LastAck || state == State::Closed ||
+                   state == State::Listen;
+        }
+    };
+
+    /// Creates an executor driving `endpoint`. Coroutines must not await
+    /// operations once the executor is gone.
+    static auto create(TcpEndpoint &endpoint) -> BasicCoroutineExecutor {
+        return BasicCoroutineExecutor{endpoint};
+    }
+
+    /// Returns an operation opening `connection` to the remote host.
+    auto connect(Connection &connection) -> ConnectOperation {
+        return {*this, connection};
+    }
+
+    /// Returns an operation sending `len` bytes of `data` via `connection`.
+    auto send(Connection &connection, const uint8_t *data, size_t len) -> SendOperation {
+        return {*this, connection, data, len};
+    }
+
+    /// Returns an operation sending `data` via `connection`.
+    template<typename std::size_t T>
+    auto send(Connection &connection, const uint8_t (&data)[T]) -> SendOperation {
+        return {*this, connection, data, T};
+    }
+
+    /// Returns an operation receiving up to `len` bytes to `buffer` via
+    /// `connection`.
+    auto receive(Connection &connection, uint8_t *buffer, size_t len) -> ReceiveOperation {
+        return {*this, connection, buffer, len};
+    }
+
+    /// Returns an operation receiving up to the size of `buffer` via
+    /// `connection`.
+    template<typename std::size_t T>
+    auto receive(Connection &connection, uint8_t (&buffer)[T]) -> ReceiveOperation {
+        return {*this, connection, buffer, T};
+    }
+
+    /// Returns an operation closing `connection`.
+    auto close(Connection &connection) -> CloseOperation {
+        return {*this, connection};
+    }
+
+    /// Makes the endpoint transmit and receive packets, waiting up to
+    /// `timeout` ms for packets, and resumes the coroutines whose operations
+    /// made progress.
+    void poll(ssize_t timeout = 0) {
+        endpoint.tx_burst(Config::BURST_SIZE);
+        endpoint.rx_burst(Config::BURST_SIZE, timeout);
+
+        resume();
+    }
+
+    /// Polls until no coroutine awaits an operation. Waits for packets up to
+    /// `max_wait` ms at a time, less if the endpoint has a packet due.
+    void run(size_t max_wait = 10) {
+        while (suspended > 0) {
+            auto now = Time::get_time_in_ms();
+            auto next = endpoint.next_deadline();
+            auto timeout = static_cast<ssize_t>(max_wait);
+
+            if (next <= now) {
+                timeout = 0;
+            } else if (next - now < max_wait) {
+                timeout = static_cast<ssize_t>(next - now);
+            }
+
+            poll(timeout);
+        }
+    }
+
+    /// Returns the number of operations coroutines are suspended on.
+    [[nodiscard]] auto pending() const -> size_t {
+        return suspended;
+    }
+
+private:
+    friend class CoroutineOperation<Config>;
+
+    explicit BasicCoroutineExecutor(TcpEndpoint &endpoint) : endpoint{endpoint} {
+        endpoint.track_progress = true;
+    };
+
+    void suspend(Operation &operation) {
+        operation.next_awaiting = operation.connection.awaiting;
+        operation.connection.awaiting = &operation;
+        suspended++;
+    }
+
+    void resume() {
+        while (auto connection = endpoint.progressed_connections.pop_front()) {
+            // resumed coroutines may suspend on the connection again
+            auto operation = connection->awaiting;
+            connection->awaiting = nullptr;
+
+            while (operation) {
+                auto next = operation->next_awaiting;
+
+                if (operation->progress()) {
+                    suspended--;
+
+                    // the operation may be gone once the coroutine continues
+                    operation->handle.resume();
+                } else {
+                    operation->next_awaiting = connection->awaiting;
+                    connection->awaiting = operation;
+                }
+
+                operation = next;
+            }
+        }
+    }
+
+    TcpEndpoint &endpoint;
+
+    // number of operations coroutines are suspended on
+    size_t suspended{};
+};
+
+/// An executor for an endpoint with the default configuration.
+using CoroutineExecutor = BasicCoroutineExecutor<DefaultConfig>;
+
+}  // namespace space_tcp
+
+#endif
+
+#endif //SPACE_TCP_COROUTINE_HPP
@@ -1,35 +1,269 @@
 #ifndef SPACE_TCP_ENDPOINT_HPP
 #define SPACE_TCP_ENDPOINT_HPP
 
+#include "compression.hpp"
+#include "config.hpp"
 #include "connection/connection.hpp"
 #include "connection/connection_manager.hpp"
+#include "list.hpp"
 #include "network/network.hpp"
+#include "pacing.hpp"
+#include "timer.hpp"
+
+#include <atomic>
 
 namespace space_tcp {
 
-/// A S3TP endpoint.
-class TcpEndpoint {
+class SpaceTcpPacket;
+
+/// A S3TP endpoint configured by `Config`, see DefaultConfig.
+template<typename Config>
+class BasicTcpEndpoint {
 public:
-    /// Creates a new endpoint. Buffer should be at least 572 bytes (maximum
-    /// size of S3TP packets: 44 B header + 512 B payload + 16 B padding).
-    static auto create(uint8_t *buffer, size_t len, ConnectionManager &connections, NetworkInterface &network) -> TcpEndpoint;
+    using Connection = BasicConnection<Config>;
+    using ConnectionManager = BasicConnectionManager<Config>;
+
+    /// Size of a S3TP packet without its payload: extended header, options
+    /// and padding.
+    static constexpr size_t PACKET_OVERHEAD = 48 + 64 + 16;
+
+    /// Maximum size of a S3TP packet with the configured payload size.
+    static constexpr size_t PACKET_SIZE = PACKET_OVERHEAD + Config::PAYLOAD_SIZE;
+
+    static_assert(Config::PAYLOAD_SIZE > 0 && Config::PAYLOAD_SIZE <= Config::MAX_PAYLOAD_SIZE,
+                  "payload size must not exceed the maximum payload size");
+    static_assert(PACKET_OVERHEAD + Config::MAX_PAYLOAD_SIZE <= 0xffff,
+                  "payload size must fit into the size field of S3TP packets");
+    static_assert(Config::WINDOW_SIZE > 1, "window must hold at least two packets");
+    static_assert(Config::PAYLOAD_SIZE * Config::WINDOW_SIZE < 0x8000,
+                  "window must not exceed half the 16-bit sequence space");
+    static_assert(Config::BURST_SIZE > 0, "bursts must contain at least one packet");
+    static_assert(Config::ACK_RATIO > 0, "at least every segment must be acknowledged");
+    static_assert(Config::ACK_DELAY < Config::MIN_RETRANSMISSION_TIMEOUT,
+                  "delayed ACKs must not trigger retransmissions");
+    static_assert(Config::RX_BUFFER_SHARE > 0 && Config::RX_BUFFER_SHARE < 100,
+                  "connection buffers must have room for received and transmitted data");
+
+    /// Creates a new endpoint. Buffer should be at least PACKET_SIZE bytes,
+    /// i.e., 640 bytes with the default configuration. On networks which
+    /// report their MTU, larger buffers allow payloads up to the MTU.
+    static auto create(uint8_t *buffer, size_t len, ConnectionManager &connections, NetworkInterface &network) -> BasicTcpEndpoint;
+
+    /// Returns the largest payload (bytes) this endpoint sends or receives,
+    /// derived from the MTU of the network and the size of the buffer.
+    [[nodiscard]] auto max_segment_size() const -> size_t {
+        return max_payload;
+    }
 
     /// Makes the endpoint process incoming packets.
     void rx(ssize_t timeout = -1);
 
+    /// Makes the endpoint process up to `max_packets` incoming packets. Waits
+    /// up to `timeout` ms for the first packet and then handles all packets
+    /// queued by the network without waiting again. Received data is
+    /// acknowledged with one ACK per connection at the end of the burst.
+    /// Returns the number of packets received.
+    auto rx_burst(size_t max_packets, ssize_t timeout = -1) -> size_t;
+
     /// Makes the endpoint transmit outgoing packets.
     void tx(ssize_t timeout = -1);
 
+    /// Makes the endpoint transmit up to `max_packets` outgoing packets of
+    /// all ready connections at once. The packets are built in the endpoint
+    /// buffer and handed to the network as a batch, i.e., the buffer should
+    /// be a multiple of PACKET_SIZE bytes. Returns the number of packets sent.
+    auto tx_burst(size_t max_packets, ssize_t timeout = -1) -> size_t;
+
+    /// Returns the time (ms, see Time::get_time_in_ms()) at which tx() has
+    /// the next packet to send: the time pacing lets the next packet of a
+    /// connection with data to send go out, or the next expiry of a TX timer.
+    /// Returns UINT64_MAX if no packet is pending. Event loops may sleep until
+    /// this time unless packets arrive.
+    auto next_deadline() -> uint64_t;
+
     /// Creates a new connection for this S3TP endpoint.
     auto create_connection(uint8_t *buffer, size_t len, uint8_t rx_port, uint8_t tx_port) -> Connection *;
 
+    /// Destroys a connection of this S3TP endpoint. Only closed connections,
+    /// i.e., connections past TIME_WAIT, and listening connections can be
+    /// destroyed. Returns whether the connection was destroyed.
+    auto destroy_connection(Connection *connection) -> bool;
+
 private:
-    TcpEndpoint(uint8_t *buffer, size_t len, ConnectionManager &connections, NetworkInterface &network) : tcp_buffer{
-            buffer}, buffer_len{len}, connections{connections}, network{network} {};
+    friend class BasicConnection<Config>;
+
+    template<typename C>
+    friend
+    class BasicCoroutineExecutor;
+
+    using ReadyQueue = IntrusiveList<Connection, &Connection::ready_hook>;
+    using TimerQueue = TimerWheel<Connection, &Connection::timer_hook, &Connection::timer_entry, Config::TIMER_SLOTS>;
+    using AckQueue = IntrusiveList<Connection, &Connection::ack_hook>;
+    using ProgressQueue = IntrusiveList<Connection, &Connection::progress_hook>;
+
+    BasicTcpEndpoint(uint8_t *buffer, size_t len, ConnectionManager &connections, NetworkInterface &network) : tcp_buffer{
+            buffer}, buffer_len{len}, max_payload{max_payload_size(len, network)}, connections{connections},
+            network{network} {
+        pacer = TokenBucket::create(network.rate(), Config::PACING_BURST * slot_size());
+    };
+
+    /// Returns the largest payload an endpoint with a buffer of `len` bytes
+    /// can send and receive via `network`.
+    static auto max_payload_size(size_t len, NetworkInterface &network) -> size_t;
+
+    /// Returns the largest payload `connection` is able to receive.
+    auto local_mss(const Connection &connection) const -> size_t;
+
+    /// Adopts the maximum segment size announced in `packet` for `connection`.
+    void agree_mss(Connection &connection, SpaceTcpPacket &packet);
+
+    /// Announces the maximum segment size of `connection` in `packet` unless
+    /// it is the default payload size or the connection sends no options.
+    void announce_mss(const Connection &connection, SpaceTcpPacket &packet);
+
+    /// Announces in the SYN or SYN+ACK `packet` that `connection` understands
+    /// header options. Options beyond the handshake, e.g., the receive window,
+    /// are only sent if both hosts announced them: hosts which do not know
+    /// options read them as payload.
+    static void announce_options(const Connection &connection, SpaceTcpPacket &packet);
+
+    /// Announces in `packet` that `connection` wants compressed payloads.
+    static void announce_compression(const Connection &connection, SpaceTcpPacket &packet);
+
+    /// Compresses the payload of `packet`, which `connection` copied from
+    /// `offset` bytes into its transmit buffer, if the connection compresses
+    /// and the payload shrinks. Incompressible data makes the connection skip
+    /// compression for COMPRESSION_BACKOFF segments.
+    void compress_payload(Connection &connection, SpaceTcpPacket &packet, size_t offset);
+
+    /// Copies up to one segment of unsent data of `connection`, starting
+    /// `offset` bytes into its transmit buffer, to the payload of `packet`.
+    static void copy_payload(Connection &connection, SpaceTcpPacket &packet, size_t offset = 0);
+
+    /// Returns the size of the packet slots in the endpoint buffer.
+    auto slot_size() const -> size_t;
+
+    /// Passes the authenticated and decrypted `packet` to its connection.
+    /// Returns whether the response in `packet` has to be sent.
+    auto rx_packet(SpaceTcpPacket &packet) -> bool;
+
+    /// Runs the state machine of `connection` for the received `packet`.
+    /// Returns whether the response in `packet` has to be sent.
+    auto rx_connection(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Builds the next packet of `connection` in `packet`. Returns whether
+    /// the packet has to be sent.
+    auto tx_connection(Connection &connection, SpaceTcpPacket &packet, uint64_t tx_time) -> bool;
+
+    /// Acknowledges received data of `connection`, either right away in
+    /// `packet` or with a single ACK at the end of a receive burst. Segments
+    /// received in order are acknowledged once ACK_RATIO segments arrived
+    /// or ACK_DELAY passed unless the ACK is `immediate`. Returns whether the
+    /// ACK in `packet` has to be sent.
+    auto acknowledge(Connection &connection, SpaceTcpPacket &packet, bool immediate) -> bool;
+
+    /// Builds an ACK for all data received in order by `connection`. Data
+    /// received out of order is reported in a selective acknowledgment.
+    static void ack_packet(Connection &connection, SpaceTcpPacket &packet);
+
+    /// Acknowledges all data received in order by `connection` with the data
+    /// packet `packet`.
+    static void piggyback_ack(Connection &connection, SpaceTcpPacket &packet);
+
+    /// Advertises the free space of the receive buffer of `connection` in
+    /// `packet`.
+    static void advertise_window(Connection &connection, SpaceTcpPacket &packet);
+
+    /// Adopts the receive window the remote host advertised in `packet`,
+    /// which acknowledges `ack_num`.
+    static void rx_window(Connection &connection, SpaceTcpPacket &packet, uint32_t ack_num);
+
+    /// Stores the payload of `packet`, which starts after a gap at `seq_num`,
+    /// in the receive buffer of `connection` until the gap is filled.
+    static void rx_out_of_order(Connection &connection, SpaceTcpPacket &packet, uint32_t seq_num);
+
+    /// Moves data received out of order by `connection` that follows the
+    /// data received in order to the readable part of the receive buffer.
+    static void reassemble(Connection &connection);
+
+    /// Adopts the selective acknowledgment of `packet` for `connection`.
+    static void rx_sack(Connection &connection, SpaceTcpPacket &packet);
+
+    /// Retransmits the oldest unacknowledged segment of `connection` without
+    /// waiting for its TX timer if duplicate ACKs or selective
+    /// acknowledgments indicate that the segment got lost.
+    static void fast_retransmit(Connection &connection);
+
+    /// Builds a retransmission of the next missing data of `connection` in
+    /// `packet`. Returns whether the packet has to be sent.
+    auto retransmit(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Rebuilds a data segment `connection` lost from the repair packet
+    /// `packet`, which is turned into the rebuilt data packet. Returns false
+    /// if no segment was rebuilt.
+    static auto rx_repair(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Builds the next repair packet of `connection` in `packet`. Returns
+    /// whether the packet has to be sent.
+    static auto tx_repair(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Passes the fountain `packet` to `connection`, i.e., adds a symbol to
+    /// the object it receives or stops sending on feedback. Returns whether
+    /// the feedback in `packet` has to be sent.
+    static auto rx_fountain(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Builds the next symbol of the object `connection` sends in `packet`.
+    /// Returns whether the packet has to be sent.
+    auto tx_fountain(Connection &connection, SpaceTcpPacket &packet) -> bool;
+
+    /// Pads, encrypts and authenticates `packet`.
+    void seal(SpaceTcpPacket &packet);
+
+    /// Seals the first `count` packets in the endpoint buffer, which is split
+    /// into slots of `slot_len` bytes, and sends them as a batch. Returns the
+    /// number of packets sent.
+    auto send_batch(size_t count, size_t slot_len) -> size_t;
+
+    /// Returns whether `connection` can transmit a packet without waiting
+    /// for its TX timer.
+    static auto tx_ready(Connection &connection) -> bool;
+
+    /// Returns the maximum amount of unacknowledged data of `connection`.
+    static auto tx_window(const Connection &connection) -> size_t;
+
+    /// Returns the sequence number of `packet` received by `connection`.
+    static auto rx_seq_num(const Connection &connection, SpaceTcpPacket &packet) -> uint32_t;
+
+    /// Returns the acknowledgment number of `packet` received by `connection`.
+    static auto rx_ack_num(const Connection &connection, SpaceTcpPacket &packet) -> uint32_t;
+
+    /// Puts `connection` on the ready queue and (re-)arms its TX timer
+    /// according to its current state.
+    void schedule(Connection &connection);
+
+    /// Queues `connection` as having made progress, i.e., it received a
+    /// packet or changed its state, if progress is tracked.
+    void progressed(Connection &connection);
+
+    /// Queues `connection` in the inbox. Safe to call from any thread.
+    void notify(Connection &connection);
+
+    /// Schedules the connections queued in the inbox in the order they were
+    /// notified.
+    void drain_inbox();
 
     uint8_t *tcp_buffer;
     size_t buffer_len;
 
+    // largest payload sent or received by this endpoint
+    size_t max_payload;
+
+    // spaces packets to the rate of the network
+    TokenBucket pacer = TokenBucket::create(0, 0);
+
+    // compresses payloads of all connections, one segment at a time
+    LzCompressor compressor = LzCompressor::create();
+
     // HMAC key
     uint8_t hmac_key[16]{0x85, 0xB1, 0x52, 0x97, 0x10, 0xE1, 0x7C, 0xB5, 0x51, 0xF5, 0x51, 0xD3, 0x2F, 0x72, 0x9D, 0x06};
 
@@ -40,12 +274,37 @@ private:
     // list of connections
     ConnectionManager &connections;
 
-    // next tx connection to check
-    size_t next_tx_connection{};
+    // connections with packets to transmit, served round-robin by tx()
+    ReadyQueue ready_connections;
+
+    // connections with a running TX timer, by deadline
+    TimerQueue timer_connections;
+
+    // connections to acknowledge at the end of a receive burst
+    AckQueue ack_connections;
+    bool coalesce_acks{};
+
+    // connections which made progress since it was last taken, tracked for
+    // a coroutine executor only
+    ProgressQueue progressed_connections;
+    bool track_progress{};
+
+    // connections notified since the last drain, a lock-free stack linked by
+    // Connection::inbox_next which application threads push to
+    std::atomic<Connection *> inbox{};
 
     NetworkInterface &network;
 };
 
+/// A S3TP endpoint with the default configuration.
+using TcpEndpoint = BasicTcpEndpoint<DefaultConfig>;
+
+// the library ships the endpoint with the default configuration
+extern template class BasicConnection<DefaultConfig>;
+extern template class BasicTcpEndpoint<DefaultConfig>;
+
 }  // namespace space_tcp
 
+#include "endpoint_impl.hpp"
+
 #endif //SPACE_TCP_ENDPOINT_HPP
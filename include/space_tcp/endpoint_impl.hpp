@@ -0,0 +1,1492 @@
+#ifndef SPACE_TCP_ENDPOINT_IMPL_HPP
+#define SPACE_TCP_ENDPOINT_IMPL_HPP
+
+// Implementation of BasicTcpEndpoint, included by endpoint.hpp.
+
+#include "protocol/space_tcp.hpp"
+#include "space_tcp/sequence.hpp"
+
+namespace space_tcp {
+
+// Standard packets carry the lower 16 bits of the sequence number only, these
+// are extended relative to the next expected sequence number.
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_seq_num(const Connection &connection, SpaceTcpPacket &packet) -> uint32_t {
+    if (packet.is_extended() || !connection.rx_next_seq_num) {
+        return packet.seq_num();
+    }
+
+    return seq_extend(packet.seq_num(), connection.rx_next_seq_num);
+}
+
+// Standard packets carry the lower 16 bits of the acknowledgment number only,
+// these are extended relative to the oldest unacknowledged sequence number.
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_ack_num(const Connection &connection, SpaceTcpPacket &packet) -> uint32_t {
+    if (packet.is_extended()) {
+        return packet.ack_num();
+    }
+
+    return seq_extend(packet.ack_num(), connection.tx_unacked);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_window(const Connection &connection) -> size_t {
+    size_t window;
+
+    if (connection.extended_seq) {
+        window = connection.mss * Config::EXTENDED_WINDOW_SIZE;
+    } else {
+        // with 16-bit sequence numbers, the window must stay below half the sequence space
+        window = connection.mss * Config::WINDOW_SIZE;
+        window = (window < 0x8000) ? window : 0x7fff;
+    }
+
+    // never send more than the remote host can store
+    window = (connection.tx_remote_window < window) ? connection.tx_remote_window : window;
+
+    if (!connection.congestion) {
+        return window;
+    }
+
+    // the congestion window only ever lowers the static window
+    auto congestion_window = connection.congestion->window();
+
+    return (congestion_window < window) ? congestion_window : window;
+}
+
+// buffer should have the (maximum) size of one S3TP packet
+template<typename Config>
+auto BasicTcpEndpoint<Config>::create(uint8_t *buffer, size_t len, ConnectionManager &connections, NetworkInterface &network) -> BasicTcpEndpoint {
+    return {buffer, len, connections, network};
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::max_payload_size(size_t len, NetworkInterface &network) -> size_t {
+    static_assert(PACKET_OVERHEAD == 48 + SpaceTcpPacket::MAX_OPTIONS_SIZE + 16,
+                  "packet overhead must cover extended header, options and padding");
+    static_assert(PACKET_OVERHEAD - 48 - SpaceTcpPacket::MAX_OPTIONS_SIZE >= LZ_IN_PLACE_MARGIN,
+                  "packet slots must leave room to decompress payloads in place");
+
+    // networks without a known MTU get packets of the configured size
+    auto payload = Config::PAYLOAD_SIZE;
+    auto mtu = network.mtu();
+
+    if (mtu) {
+        payload = (mtu > PACKET_OVERHEAD) ? mtu - PACKET_OVERHEAD : 0;
+        payload = (payload > Config::MAX_PAYLOAD_SIZE) ? Config::MAX_PAYLOAD_SIZE : payload;
+    }
+
+    // at least one packet has to fit into the endpoint buffer
+    auto buffer_payload = (len > PACKET_OVERHEAD) ? len - PACKET_OVERHEAD : 0;
+    payload = (payload > buffer_payload) ? buffer_payload : payload;
+
+    if (payload == 0) {
+        error("endpoint buffer or MTU of network too small for S3TP packets");
+    }
+
+    return payload;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::local_mss(const Connection &connection) const -> size_t {
+    // a segment must not fill more than half of the receive buffer
+    auto receivable = connection.receive_buffer.capacity() / 2;
+
+    return (max_payload < receivable) ? max_payload : receivable;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::agree_mss(Connection &connection, SpaceTcpPacket &packet) {
+    // hosts without the option receive packets of the default size
+    size_t remote_mss = packet.mss_option();
+    remote_mss = remote_mss ? remote_mss : Config::PAYLOAD_SIZE;
+
+    connection.mss = (remote_mss < max_payload) ? remote_mss : max_payload;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::announce_mss(const Connection &connection, SpaceTcpPacket &packet) {
+    auto mss = local_mss(connection);
+
+    if (mss != Config::PAYLOAD_SIZE && connection.options) {
+        packet.set_mss_option(static_cast<uint16_t>(mss));
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::announce_options(const Connection &connection, SpaceTcpPacket &packet) {
+    if (connection.options) {
+        packet.set_flags(packet.flags() | Flag::OptOk);
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::announce_compression(const Connection &connection, SpaceTcpPacket &packet) {
+    if (connection.compression) {
+        packet.set_compression_option(Compression::Lz);
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::compress_payload(Connection &connection, SpaceTcpPacket &packet, size_t offset) {
+    size_t len = packet.size();
+
+    if (!connection.compression || len < LzCompressor::MIN_INPUT) {
+        return;
+    }
+
+    if (connection.compress_skip > 0) {
+        connection.compress_skip--;
+        return;
+    }
+
+    // compress straight from the transmit buffer, which may wrap around
+    size_t first_len;
+    auto first = connection.transmit_buffer.peek(offset, first_len);
+    first_len = (first_len < len) ? first_len : len;
+
+    size_t second_len;
+    auto second = connection.transmit_buffer.peek(offset + first_len, second_len);
+
+    auto compressed = compressor.compress(first, first_len, second, len - first_len, packet.payload());
+
+    if (compressed == 0) {
+        // the attempt overwrote the payload
+        connection.transmit_buffer.copy(packet.payload(), len, offset);
+        connection.compress_skip = Config::COMPRESSION_BACKOFF;
+
+        return;
+    }
+
+    packet.set_flags(packet.flags() | Flag::Cmp);
+    packet.set_size(static_cast<uint16_t>(compressed));
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::copy_payload(Connection &connection, SpaceTcpPacket &packet, size_t offset) {
+    auto len = connection.transmit_buffer.used_space() - offset;
+    len = (len > connection.mss) ? connection.mss : len;
+
+    // data is copied straight from the transmit buffer into the packet
+    packet.set_size(static_cast<uint16_t>(connection.transmit_buffer.copy(packet.payload(), len, offset)));
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::slot_size() const -> size_t {
+    auto slot_len = max_payload + PACKET_OVERHEAD;
+
+    return (buffer_len < slot_len) ? buffer_len : slot_len;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::rx(ssize_t timeout) {
+    rx_burst(1, timeout);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_burst(size_t max_packets, ssize_t timeout) -> size_t {
+    drain_inbox();
+
+    // split endpoint buffer into one slot per packet
+    auto slot_len = slot_size();
+    auto slots = buffer_len / slot_len;
+    slots = (slots > Config::BURST_SIZE) ? Config::BURST_SIZE : slots;
+    max_packets = (max_packets > slots) ? slots : max_packets;
+
+    size_t lens[Config::BURST_SIZE];
+    auto received = network.receive_batch(tcp_buffer, slot_len, lens, max_packets, timeout);
+
+    // authenticate and decrypt all packets of the burst
+    for (size_t i = 0; i < received; i++) {
+        auto packet = SpaceTcpPacket::create_unchecked(tcp_buffer + i * slot_len, lens[i]);
+
+        // check version, length, HMAC, etc.
+        if (!packet.is_valid_packet(hmac_key, sizeof(hmac_key))) {
+            // received S3TP packet was not a valid packet :-/
+            lens[i] = 0;
+            continue;
+        }
+
+        if (packet.size() > 0) {
+            // decrypt payload with AES128-CBC
+            packet.decrypt_payload(aes_key, aes_iv);
+
+            // remove PKCS#7 padding from payload
+            packet.depad_payload();
+        }
+    }
+
+    // ACKs for received data are sent once per connection after the burst
+    coalesce_acks = true;
+
+    for (size_t i = 0; i < received; i++) {
+        if (lens[i] == 0) {
+            continue;
+        }
+
+        auto packet = SpaceTcpPacket::create_unchecked(tcp_buffer + i * slot_len, slot_len);
+
+        if (!rx_packet(packet)) {
+            continue;
+        }
+
+        seal(packet);
+
+        network.send(tcp_buffer + i * slot_len, packet.length(), 10);
+    }
+
+    coalesce_acks = false;
+
+    size_t batched = 0;
+
+    while (!ack_connections.empty()) {
+        auto packet = SpaceTcpPacket::create_unchecked(tcp_buffer + batched * slot_len, slot_len);
+
+        ack_packet(*ack_connections.pop_front(), packet);
+
+        if (++batched == slots) {
+            send_batch(batched, slot_len);
+            batched = 0;
+        }
+    }
+
+    send_batch(batched, slot_len);
+
+    return received;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_packet(SpaceTcpPacket &packet) -> bool {
+    // find connection
+    auto src_port = packet.src_port();
+    auto dst_port = packet.dst_port();
+    auto connection = connections.find_connection(dst_port, src_port);
+
+    if (!connection) {
+        // send RST since received S3TP does not belong to any connection
+        packet.initialize(dst_port, src_port, packet.ack_num(), packet.is_extended());
+        packet.set_flags(Flag::Rst);
+
+        return true;
+    }
+
+    // fountain transfers bypass the state machine
+    if (packet.is_fountain()) {
+        auto send_packet = rx_fountain(*connection, packet);
+
+        schedule(*connection);
+        progressed(*connection);
+
+        return send_packet;
+    }
+
+    // compressed payloads are restored before anything reads them
+    if ((packet.flags() & Flag::Cmp) == Flag::Cmp && (!connection->compression || !packet.decompress_payload())) {
+        warn("S3TP packet with invalid compressed payload");
+        return false;
+    }
+
+    // repair packets only matter if they rebuild a lost segment
+    if (packet.is_repair() && !rx_repair(*connection, packet)) {
+        return false;
+    }
+
+    // protected data segments are added to the code before the packet buffer
+    // is reused for the response
+    fec_tag tag{};
+    if (connection->fec && packet.size() > 0 && packet.fec_option(tag)) {
+        connection->fec->received(tag, packet.payload(), packet.size());
+    }
+
+    auto send_packet = rx_connection(*connection, packet);
+
+    schedule(*connection);
+    progressed(*connection);
+
+    return send_packet;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_connection(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    auto send_packet = false;
+
+    // the packet buffer is reused for the response, read numbers up front
+    auto seq_num = rx_seq_num(connection, packet);
+    auto ack_num = rx_ack_num(connection, packet);
+
+    switch (connection.state) {
+        case State::Closed: {
+            send_packet = true;
+
+            // send RST on packets for closed connection
+            packet.initialize(packet.dst_port(), packet.src_port(), connection.tx_next_seq_num, packet.is_extended());
+            packet.set_flags(Flag::Rst);
+
+            break;
+        }
+        case State::Listen: {
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            if ((packet.flags() & Flag::Syn) != Flag::Syn) {
+                return false;
+            }
+
+            auto to_ack_num = seq_num + packet.size() + 1;
+
+            // use 32-bit sequence numbers, header options and compression if
+            // both hosts want them
+            connection.extended_seq = connection.extended_seq && packet.is_extended();
+            connection.options = connection.options && (packet.flags() & Flag::OptOk) == Flag::OptOk;
+            connection.compression = connection.compression && packet.compression_option() == Compression::Lz;
+
+            agree_mss(connection, packet);
+
+            connection.state = State::SynReceived;
+            connection.rx_initial_seq_num = seq_num;
+            connection.rx_next_seq_num = to_ack_num;
+
+            // get payload data
+            connection.receive_buffer.push_back(packet.payload(), packet.size());
+
+            send_packet = true;
+
+            // send SYN+ACK on SYN
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Syn | Flag::Ack);
+            packet.set_ack_num(to_ack_num);
+            announce_options(connection, packet);
+            announce_mss(connection, packet);
+            announce_compression(connection, packet);
+            copy_payload(connection, packet);
+
+            connection.tx_next_seq_num += packet.size() + 1;
+            connection.rx_acked = to_ack_num;
+
+            connection.tx_last_time = Time::get_time_in_ms();
+
+            break;
+        }
+        case State::SynSent: {
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            if ((packet.flags() & (Flag::Syn | Flag::Ack)) != (Flag::Syn | Flag::Ack)) {
+                return false;
+            }
+
+            auto acknowledged_data = ack_num - connection.tx_unacked - 1;
+            connection.transmit_buffer.pop_front(nullptr, acknowledged_data);
+
+            auto to_ack_num = seq_num + packet.size() + 1;
+
+            // the remote host answers with 32-bit sequence numbers, header
+            // options and the compression option if it supports them
+            connection.extended_seq = connection.extended_seq && packet.is_extended();
+            connection.options = connection.options && (packet.flags() & Flag::OptOk) == Flag::OptOk;
+            connection.compression = connection.compression && packet.compression_option() == Compression::Lz;
+
+            agree_mss(connection, packet);
+
+            connection.state = State::Established;
+            connection.rx_initial_seq_num = seq_num;
+            connection.rx_next_seq_num = to_ack_num;
+            connection.tx_unacked = ack_num;
+
+            connection.rtt_acknowledged(ack_num, Time::get_time_in_ms());
+
+            if (connection.congestion) {
+                connection.congestion->reset(connection.mss);
+            }
+
+            connection.receive_buffer.push_back(packet.payload(), packet.size());
+
+            send_packet = true;
+
+            // send ACK on SYN+ACK
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Ack);
+            packet.set_ack_num(to_ack_num);
+            advertise_window(connection, packet);
+
+            connection.rx_acked = to_ack_num;
+
+            break;
+        }
+        case State::SynReceived: {
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            // SYN again? resend SYN+ACK in tx()
+            if ((packet.flags() & Flag::Syn) == Flag::Syn) {
+                break;
+            }
+
+            // ACK for our SYN+ACK? -> connection established
+            if (((packet.flags() & Flag::Ack) == Flag::Ack)) {
+                if (ack_num == connection.tx_next_seq_num) {
+                    connection.state = State::Established;
+                    connection.tx_unacked = ack_num;
+                    connection.tx_next_seq_num = ack_num;
+
+                    if (connection.congestion) {
+                        connection.congestion->reset(connection.mss);
+                    }
+                }
+            }
+
+            break;
+        }
+        case State::Established: {
+            if (((packet.flags() & (Flag::Syn | Flag::Ack)) == (Flag::Syn | Flag::Ack))) {
+                // old packet that we processed already
+
+                send_packet = true;
+
+                auto to_ack_num = seq_num + packet.size() + 1;
+
+                // send ACK on SYN+ACK
+                packet.initialize(connection.src_port, connection.dst_port, connection.tx_unacked, connection.extended_seq);
+                packet.set_flags(Flag::Ack);
+                packet.set_ack_num(to_ack_num);
+            } else {
+                // ACKs are sent on their own or piggybacked on data
+                if (((packet.flags() & Flag::Ack) == Flag::Ack)) {
+                    // new ACK?
+                    if (seq_gt(ack_num, connection.tx_unacked)) {
+                        auto acknowledged_data = ack_num - connection.tx_unacked;
+                        auto in_flight = connection.tx_data_in_flight();
+                        connection.transmit_buffer.pop_front(nullptr, acknowledged_data);
+                        connection.tx_unacked = ack_num;
+
+                        // missing data is retransmitted once the TX timer expires,
+                        // data sent in between stays in flight
+                        if (seq_lt(connection.tx_next_seq_num, ack_num)) {
+                            connection.tx_next_seq_num = ack_num;
+                        }
+
+                        // acknowledged data is not retransmitted
+                        if (seq_lt(connection.tx_rtx_next, ack_num)) {
+                            connection.tx_rtx_next = ack_num;
+                        }
+
+                        if (seq_lt(connection.tx_rtx_end, ack_num)) {
+                            connection.tx_rtx_end = ack_num;
+                        }
+
+                        connection.tx_dup_acks = 0;
+                        connection.tx_fast_retransmitted = false;
+
+                        auto rtt = connection.rtt_acknowledged(ack_num, Time::get_time_in_ms());
+
+                        if (connection.congestion) {
+                            connection.congestion->acknowledged(acknowledged_data, in_flight, rtt);
+                        }
+                    } else if (ack_num == connection.tx_unacked && connection.tx_unacked != connection.tx_next_seq_num &&
+                               packet.size() == 0) {
+                        // duplicate ACKs carry no data
+                        connection.tx_dup_acks++;
+                    }
+
+                    rx_window(connection, packet, ack_num);
+                    rx_sack(connection, packet);
+                    fast_retransmit(connection);
+                }
+
+                // no data to receive?
+                if (packet.size() == 0 && (packet.flags() & Flag::Fin) != Flag::Fin) {
+                    break;
+                }
+
+                auto to_ack_num = seq_num + packet.size();
+
+                // gaps and duplicates are reported to the sender right away
+                auto immediate = true;
+
+                if (connection.rx_next_seq_num && seq_num == connection.rx_next_seq_num) {
+                    // next expected segment
+
+                    // get payload data
+                    auto stored = connection.receive_buffer.push_back(packet.payload(), packet.size());
+                    stored = (stored > 0) ? stored : 0;
+
+                    // receive buffer full? only acknowledge stored data
+                    if (static_cast<size_t>(stored) < packet.size()) {
+                        connection.rx_next_seq_num += static_cast<uint32_t>(stored);
+                        connection.rx_stream_offset += stored;
+                        connection.rx_acked = connection.rx_next_seq_num;
+
+                        send_packet = acknowledge(connection, packet, true);
+
+                        break;
+                    }
+
+                    if ((packet.flags() & Flag::Fin) == Flag::Fin) {
+                        to_ack_num++;
+
+                        send_packet = true;
+
+                        // send FIN+ACK on FIN
+                        packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+                        packet.set_flags(Flag::Fin | Flag::Ack);
+                        packet.set_ack_num(to_ack_num);
+
+                        connection.state = State::LastAck;
+
+                        connection.tx_next_seq_num++;
+
+                        connection.close_at = Time::get_time_in_ms() + Config::TIMEWAIT * 1000;
+                        connection.tx_last_time = Time::get_time_in_ms();
+
+                        connection.rx_acked = to_ack_num;
+                        connection.rx_next_seq_num = to_ack_num;
+
+                        connection.ack_sent();
+
+                        break;
+                    }
+
+                    connection.rx_next_seq_num = to_ack_num;
+                    connection.rx_stream_offset += packet.size();
+
+                    immediate = connection.ooo_segments.contains_segments() || packet.size() == 0;
+
+                    // the segment may fill the gap before data received out of order
+                    reassemble(connection);
+
+                    connection.rx_acked = connection.rx_next_seq_num;
+                } else if (connection.rx_next_seq_num && seq_gt(seq_num, connection.rx_next_seq_num)) {
+                    rx_out_of_order(connection, packet, seq_num);
+                }
+
+                // acknowledge last segment received in order, i.e., earlier
+                // segments are acknowledged again and segments received out
+                // of order are acknowledged selectively
+                send_packet = acknowledge(connection, packet, immediate);
+            }
+
+            break;
+        }
+        case State::FinWait: {
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            if ((packet.flags() & (Flag::Fin | Flag::Ack)) != (Flag::Fin | Flag::Ack)) {
+                if (seq_gt(ack_num, connection.tx_unacked)) {
+                    auto acknowledged_data = ack_num - connection.tx_unacked;
+                    connection.transmit_buffer.pop_front(nullptr, acknowledged_data);
+                    connection.tx_unacked = ack_num;
+                }
+
+                return false;
+            }
+
+            auto acknowledged_data = ack_num - connection.tx_unacked - 1;
+            connection.transmit_buffer.pop_front(nullptr, acknowledged_data);
+
+            connection.tx_unacked += acknowledged_data;
+
+            auto to_ack_num = seq_num + packet.size() + 1;
+
+            send_packet = true;
+
+            // send ACK on FIN+ACK
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Ack);
+            packet.set_ack_num(to_ack_num);
+
+            connection.rx_acked = to_ack_num;
+            connection.state = State::TimeWait;
+
+            break;
+        }
+        case State::TimeWait: {
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            if ((packet.flags() & (Flag::Fin | Flag::Ack)) != (Flag::Fin | Flag::Ack)) {
+                return false;
+            }
+
+            send_packet = true;
+
+            // send ACK on FIN+ACK
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num + 1, connection.extended_seq);
+            packet.set_flags(Flag::Ack);
+            packet.set_ack_num(connection.rx_acked);
+
+            break;
+        }
+        case State::Closing:
+        case State::CloseWait:
+        case State::Fountain: {
+            break;
+        }
+        case State::LastAck: {
+            // FIN again? resend FIN+ACK in tx()
+            if ((packet.flags() & Flag::Fin) == Flag::Fin) {
+                return false;
+            }
+
+            if (connection.rx_next_seq_num && seq_lt(seq_num, connection.rx_next_seq_num)) {
+                return false;
+            }
+
+            if ((packet.flags() & Flag::Ack) != Flag::Ack) {
+                return false;
+            }
+
+            connection.state = State::Closed;
+            connection.rx_next_seq_num++;
+            connection.tx_unacked++;
+
+            break;
+        }
+        default:
+            error("this should not happen");
+    }
+
+    return send_packet;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::tx(ssize_t timeout) {
+    tx_burst(1, timeout);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_burst(size_t max_packets, ssize_t timeout) -> size_t {
+    drain_inbox();
+
+    auto tx_time = Time::get_time_in_ms();
+
+    // connections with an expired TX timer have to retransmit or acknowledge
+    while (auto expired = timer_connections.pop_expired(tx_time)) {
+        ready_connections.push_back(expired);
+    }
+
+    // split endpoint buffer into one slot per packet
+    auto slot_len = slot_size();
+    auto slots = buffer_len / slot_len;
+    slots = (slots > Config::BURST_SIZE) ? Config::BURST_SIZE : slots;
+
+    size_t batched = 0;
+    size_t sent = 0;
+
+    // stop once every ready connection was served without building a packet
+    size_t misses = 0;
+
+    auto pace_time = Time::get_time_in_us();
+
+    while (sent + batched < max_packets && misses < ready_connections.size() && pacer.ready(pace_time)) {
+        auto connection = ready_connections.pop_front();
+
+        // connection has to wait for its own rate
+        if (!connection->pacer.ready(pace_time)) {
+            schedule(*connection);
+            misses++;
+            continue;
+        }
+
+        auto packet = SpaceTcpPacket::create_unchecked(tcp_buffer + batched * slot_len, slot_len);
+
+        auto state = connection->state;
+        auto send_packet = tx_connection(*connection, packet, tx_time);
+
+        if (connection->state != state) {
+            progressed(*connection);
+        }
+
+        if (send_packet) {
+            pacer.consume(packet.length(), pace_time);
+            connection->pacer.consume(packet.length(), pace_time);
+        }
+
+        // a connection with more data to send goes to the back of the queue
+        schedule(*connection);
+
+        if (!send_packet) {
+            misses++;
+            continue;
+        }
+
+        misses = 0;
+
+        if (++batched == slots) {
+            sent += send_batch(batched, slot_len);
+            batched = 0;
+        }
+    }
+
+    sent += send_batch(batched, slot_len);
+
+    return sent;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::next_deadline() -> uint64_t {
+    drain_inbox();
+
+    auto deadline = timer_connections.earliest();
+
+    if (ready_connections.empty()) {
+        return deadline;
+    }
+
+    // earliest time a ready connection may send
+    auto now = Time::get_time_in_us();
+    auto release = UINT64_MAX;
+
+    for (auto connection = ready_connections.front(); connection; connection = ReadyQueue::next(connection)) {
+        auto connection_release = connection->pacer.release_time(now);
+        release = (connection_release < release) ? connection_release : release;
+    }
+
+    auto network_release = pacer.release_time(now);
+    release = (network_release > release) ? network_release : release;
+
+    // round up to full milliseconds
+    auto ready = Time::get_time_in_ms() + (release - now + 999) / 1000;
+
+    return (ready < deadline) ? ready : deadline;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::send_batch(size_t count, size_t slot_len) -> size_t {
+    if (count == 0) {
+        return 0;
+    }
+
+    network_buffer batch[Config::BURST_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        auto packet = SpaceTcpPacket::create_unchecked(tcp_buffer + i * slot_len, slot_len);
+
+        seal(packet);
+
+        batch[i] = {tcp_buffer + i * slot_len, packet.length()};
+    }
+
+    return network.send_batch(batch, count, 10);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::acknowledge(Connection &connection, SpaceTcpPacket &packet, bool immediate) -> bool {
+    connection.rx_unacked_segments++;
+
+    if (!immediate && connection.rx_unacked_segments < Config::ACK_RATIO) {
+        // the timer sends the ACK unless more segments arrive
+        if (!connection.ack_delayed) {
+            connection.ack_delayed = true;
+            connection.ack_deadline = Time::get_time_in_ms() + Config::ACK_DELAY;
+        }
+
+        return false;
+    }
+
+    if (coalesce_acks) {
+        ack_connections.push_back(&connection);
+        return false;
+    }
+
+    ack_packet(connection, packet);
+
+    return true;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::ack_packet(Connection &connection, SpaceTcpPacket &packet) {
+    packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+    packet.set_flags(Flag::Ack);
+    packet.set_ack_num(connection.rx_acked);
+    advertise_window(connection, packet);
+
+    connection.ack_sent();
+
+    segment ranges[MAX_SACK_BLOCKS];
+    auto count = connection.ooo_segments.ranges(ranges, MAX_SACK_BLOCKS);
+
+    if (count == 0 || !connection.options) {
+        return;
+    }
+
+    // stream offsets of the stored segments to sequence numbers
+    seq_range blocks[MAX_SACK_BLOCKS];
+
+    for (size_t i = 0; i < count; i++) {
+        blocks[i].start = connection.rx_next_seq_num + static_cast<uint32_t>(ranges[i].offset - connection.rx_stream_offset);
+        blocks[i].end = blocks[i].start + static_cast<uint32_t>(ranges[i].len);
+    }
+
+    packet.set_sack_option(blocks, count);
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::piggyback_ack(Connection &connection, SpaceTcpPacket &packet) {
+    packet.set_flags(Flag::Ack);
+    packet.set_ack_num(connection.rx_acked);
+
+    advertise_window(connection, packet);
+
+    // a delayed ACK is not needed anymore
+    connection.ack_sent();
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::advertise_window(Connection &connection, SpaceTcpPacket &packet) {
+    auto window = connection.receive_buffer.free_space();
+    window = (window < UINT32_MAX) ? window : UINT32_MAX;
+
+    // hosts without header options rely on the static window
+    if (connection.options) {
+        packet.set_window_option(static_cast<uint32_t>(window));
+    }
+
+    connection.rx_advertised = window;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::rx_window(Connection &connection, SpaceTcpPacket &packet, uint32_t ack_num) {
+    uint32_t window;
+
+    // hosts without the option are limited by the static window only, older
+    // ACKs might advertise outdated windows
+    if (!packet.window_option(window) || seq_lt(ack_num, connection.tx_unacked)) {
+        return;
+    }
+
+    // the window closes, probe it after the retransmission timeout
+    if (window == 0 && connection.tx_remote_window != 0) {
+        connection.tx_last_time = Time::get_time_in_ms();
+    }
+
+    // the window opens again, the remote host dropped the probes sent meanwhile
+    if (window != 0 && connection.tx_remote_window == 0 && connection.tx_data_in_flight() > 0) {
+        connection.tx_rtx_next = connection.tx_unacked;
+        connection.tx_rtx_end = connection.tx_next_seq_num;
+    }
+
+    connection.tx_remote_window = window;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::rx_out_of_order(Connection &connection, SpaceTcpPacket &packet, uint32_t seq_num) {
+    // a FIN is only accepted in order
+    if (packet.size() == 0 || (packet.flags() & Flag::Fin) == Flag::Fin) {
+        return;
+    }
+
+    size_t distance = seq_num - connection.rx_next_seq_num;
+    auto offset = connection.rx_stream_offset + distance;
+
+    // received before or no room behind the gap
+    if (connection.ooo_segments.contains(offset, packet.size()) ||
+        distance + packet.size() > connection.receive_buffer.free_space()) {
+        return;
+    }
+
+    if (!connection.ooo_segments.insert(offset, packet.size())) {
+        return;
+    }
+
+    // data is stored behind the readable part of the receive buffer
+    connection.receive_buffer.push_back(packet.payload(), packet.size(), distance);
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::reassemble(Connection &connection) {
+    while (connection.ooo_segments.contains_segments()) {
+        auto segment = connection.ooo_segments.get_smallest_offset_segment();
+
+        // gap before the segment
+        if (segment.offset > connection.rx_stream_offset) {
+            break;
+        }
+
+        auto end = segment.offset + segment.len;
+
+        if (end > connection.rx_stream_offset) {
+            auto bytes = end - connection.rx_stream_offset;
+
+            connection.receive_buffer.advance_head(bytes);
+            connection.rx_stream_offset += bytes;
+            connection.rx_next_seq_num += static_cast<uint32_t>(bytes);
+        }
+
+        connection.ooo_segments.remove(segment.offset, segment.len);
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::rx_sack(Connection &connection, SpaceTcpPacket &packet) {
+    seq_range blocks[MAX_SACK_BLOCKS];
+    auto count = packet.sack_option(blocks, MAX_SACK_BLOCKS);
+
+    connection.tx_sacked_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        auto block = blocks[i];
+
+        // with 16-bit sequence numbers, the remote host only knows the lower 16 bits
+        if (!packet.is_extended()) {
+            block.start = seq_extend(static_cast<uint16_t>(block.start), connection.tx_unacked);
+            block.end = seq_extend(static_cast<uint16_t>(block.end), connection.tx_unacked);
+        }
+
+        // ignore blocks outside of the data in flight
+        if (!seq_gt(block.start, connection.tx_unacked) || !seq_gt(block.end, block.start) ||
+            seq_gt(block.end, connection.tx_next_seq_num)) {
+            continue;
+        }
+
+        connection.tx_sacked[connection.tx_sacked_count++] = block;
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::fast_retransmit(Connection &connection) {
+    if (Config::DUP_ACK_THRESHOLD == 0 || connection.tx_fast_retransmitted || connection.tx_retransmitting()) {
+        return;
+    }
+
+    // ACKs are coalesced per receive burst, so one ACK may report several
+    // segments beyond the lost one
+    if (connection.tx_dup_acks < Config::DUP_ACK_THRESHOLD &&
+        connection.tx_sacked_data() < Config::DUP_ACK_THRESHOLD * connection.mss) {
+        return;
+    }
+
+    connection.tx_fast_retransmitted = true;
+
+    if (connection.congestion) {
+        connection.congestion->lost(connection.tx_data_in_flight());
+    }
+
+    connection.tx_rtx_next = connection.tx_unacked;
+    connection.tx_rtx_end = connection.tx_unacked + static_cast<uint32_t>(connection.mss);
+
+    if (seq_gt(connection.tx_rtx_end, connection.tx_next_seq_num)) {
+        connection.tx_rtx_end = connection.tx_next_seq_num;
+    }
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::retransmit(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    auto seq_num = connection.tx_rtx_next;
+
+    // skip data the remote host received already
+    for (auto skipped = true; skipped;) {
+        skipped = false;
+
+        for (size_t i = 0; i < connection.tx_sacked_count; i++) {
+            auto &block = connection.tx_sacked[i];
+
+            if (seq_geq(seq_num, block.start) && seq_lt(seq_num, block.end)) {
+                seq_num = block.end;
+                skipped = true;
+            }
+        }
+    }
+
+    if (!seq_lt(seq_num, connection.tx_rtx_end)) {
+        connection.tx_rtx_next = connection.tx_rtx_end;
+        return false;
+    }
+
+    // retransmit up to the next data the remote host received
+    size_t len = connection.tx_rtx_end - seq_num;
+
+    for (size_t i = 0; i < connection.tx_sacked_count; i++) {
+        auto &block = connection.tx_sacked[i];
+
+        if (seq_gt(block.start, seq_num) && block.start - seq_num < len) {
+            len = block.start - seq_num;
+        }
+    }
+
+    packet.initialize(connection.src_port, connection.dst_port, seq_num, connection.extended_seq);
+    piggyback_ack(connection, packet);
+    copy_payload(connection, packet, seq_num - connection.tx_unacked);
+
+    if (packet.size() > len) {
+        packet.set_size(static_cast<uint16_t>(len));
+    }
+
+    if (packet.size() == 0) {
+        connection.tx_rtx_next = connection.tx_rtx_end;
+        return false;
+    }
+
+    connection.tx_rtx_next = seq_num + packet.size();
+
+    compress_payload(connection, packet, seq_num - connection.tx_unacked);
+
+    connection.rtt_cancel();
+
+    if (connection.fec) {
+        connection.fec->retransmitted();
+    }
+
+    return true;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_repair(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    if (!connection.fec || connection.state != State::Established) {
+        return false;
+    }
+
+    fec_tag tag{};
+    seq_range segments[ForwardErrorCorrection::MAX_LANE_SEGMENTS];
+    auto count = packet.repair_option(tag, segments, ForwardErrorCorrection::MAX_LANE_SEGMENTS);
+
+    auto i = connection.fec->recover(tag, segments, count, packet.payload(), packet.size());
+
+    if (i == count) {
+        return false;
+    }
+
+    auto segment = segments[i];
+    size_t len = segment.end - segment.start;
+
+    // received in order meanwhile, e.g., retransmitted
+    if (len == 0 || len > packet.size() || seq_leq(segment.end, connection.rx_next_seq_num)) {
+        return false;
+    }
+
+    // the rebuilt payload moves to the front of a data packet without options
+    auto payload = packet.payload();
+
+    packet.initialize(packet.src_port(), packet.dst_port(), segment.start, true);
+    memmove(packet.payload(), payload, len);
+    packet.set_size(static_cast<uint16_t>(len));
+
+    return true;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_repair(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    ForwardErrorCorrection::repair_segment repair{};
+
+    if (!connection.fec->next_repair(repair)) {
+        return false;
+    }
+
+    // repair packets occupy no sequence numbers, the sequence number of the
+    // first covered segment only varies the IV
+    packet.initialize(connection.src_port, connection.dst_port, repair.segments[0].start, true);
+    packet.set_msg_type(static_cast<uint8_t>(MsgType::Repair));
+    packet.set_repair_option(repair.tag, repair.segments, repair.count);
+    packet.set_payload(repair.payload, repair.len);
+
+    return true;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::rx_fountain(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    if (connection.state != State::Fountain) {
+        return false;
+    }
+
+    // feedback: the remote host rebuilt the object
+    if ((packet.flags() & Flag::Ack) == Flag::Ack) {
+        if (connection.fountain_encoder) {
+            connection.end_fountain();
+        }
+
+        return false;
+    }
+
+    auto decoder = connection.fountain_decoder;
+
+    if (!decoder || packet.size() == 0) {
+        return false;
+    }
+
+    auto id = packet.seq_num();
+
+    decoder->add(id, packet.object_option(), packet.payload(), packet.size());
+
+    if (!decoder->complete() || !connection.fountain_feedback) {
+        return false;
+    }
+
+    // repeated for every symbol still arriving in case feedback gets lost
+    packet.initialize(connection.src_port, connection.dst_port, id, true);
+    packet.set_msg_type(static_cast<uint8_t>(MsgType::Fountain));
+    packet.set_flags(Flag::Ack);
+    packet.set_ack_num(id);
+
+    return true;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_fountain(Connection &connection, SpaceTcpPacket &packet) -> bool {
+    auto encoder = connection.fountain_encoder;
+
+    // receiving connection
+    if (!encoder) {
+        return false;
+    }
+
+    if (encoder->symbol_size() > max_payload) {
+        warn("fountain symbols exceed the maximum segment size of the endpoint");
+        connection.end_fountain();
+        return false;
+    }
+
+    auto id = connection.fountain_symbol++;
+
+    packet.initialize(connection.src_port, connection.dst_port, id, true);
+    packet.set_msg_type(static_cast<uint8_t>(MsgType::Fountain));
+    packet.set_object_option(static_cast<uint32_t>(encoder->object_size()));
+    packet.set_size(static_cast<uint16_t>(encoder->symbol(id, packet.payload())));
+
+    if (connection.fountain_symbols_left != SIZE_MAX && --connection.fountain_symbols_left == 0) {
+        connection.end_fountain();
+    }
+
+    return true;
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::seal(SpaceTcpPacket &packet) {
+    // pad and encrypt payload
+    if (packet.size() > 0) {
+        packet.pad_payload();
+        packet.encrypt_payload(aes_key, aes_iv);
+    }
+
+    packet.update_hmac(hmac_key, sizeof(hmac_key));
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_connection(Connection &connection, SpaceTcpPacket &packet, uint64_t tx_time) -> bool {
+    auto timer_expired = connection.tx_timer_expired(tx_time);
+
+    // repeated expiry backs off the retransmission timeout
+    if (timer_expired) {
+        connection.rto_back_off();
+    }
+
+    switch (connection.state) {
+        case State::Closed: {
+            if (!connection.tx_data_to_send() && !connection.connect_requested) {
+                return false;
+            }
+
+            connection.connect_requested = false;
+
+            // the remote host accepts payloads of the default size until it
+            // announces its maximum segment size
+            connection.mss = (Config::PAYLOAD_SIZE < max_payload) ? Config::PAYLOAD_SIZE : max_payload;
+
+            // send SYN packet
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Syn);
+            announce_options(connection, packet);
+            announce_mss(connection, packet);
+            announce_compression(connection, packet);
+            copy_payload(connection, packet);
+
+            // update next sequence number
+            connection.tx_next_seq_num += packet.size() + 1;
+
+            connection.rtt_start(connection.tx_next_seq_num, tx_time);
+
+            connection.state = State::SynSent;
+
+            break;
+        }
+        case State::Listen: {
+            return false;
+        }
+        case State::SynSent: {
+            if (!timer_expired) {
+                return false;
+            }
+
+            // send SYN packet
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_initial_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Syn);
+            announce_options(connection, packet);
+            announce_mss(connection, packet);
+            announce_compression(connection, packet);
+            copy_payload(connection, packet);
+
+            connection.rtt_cancel();
+
+            break;
+        }
+        case State::SynReceived: {
+            if (!timer_expired) {
+                return false;
+            }
+
+            // send SYN+ACK on SYN
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_initial_seq_num, connection.extended_seq);
+            packet.set_flags(Flag::Syn | Flag::Ack);
+            packet.set_ack_num(connection.rx_acked);
+            announce_options(connection, packet);
+            announce_mss(connection, packet);
+            announce_compression(connection, packet);
+            copy_payload(connection, packet);
+
+            break;
+        }
+        case State::Established: {
+            // delayed ACK due?
+            if (connection.ack_timer_expired(tx_time)) {
+                ack_packet(connection, packet);
+                break;
+            }
+
+            // timer expired? retransmit data not reported as received
+            if (timer_expired) {
+                // unanswered window probes do not indicate congestion
+                if (connection.congestion && connection.tx_remote_window != 0) {
+                    connection.congestion->timed_out(connection.tx_data_in_flight());
+                }
+
+                connection.tx_rtx_next = connection.tx_unacked;
+                connection.tx_rtx_end = connection.tx_next_seq_num;
+            }
+
+            if (connection.tx_retransmitting() && retransmit(connection, packet)) {
+                break;
+            }
+
+            // repair packets follow the data segments of their group
+            if (connection.fec && connection.fec->repair_pending() && tx_repair(connection, packet)) {
+                break;
+            }
+
+            auto in_flight = connection.tx_data_in_flight();
+            auto window = tx_window(connection);
+
+            // window of the remote host closed? probe it with a single byte
+            // on expiry of the TX timer
+            if (connection.tx_window_closed()) {
+                if (connection.tx_timer_deadline() > tx_time) {
+                    return false;
+                }
+
+                window = 1;
+            }
+
+            if (!connection.tx_data_to_send() || in_flight >= window) {
+                return false;
+            }
+
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num, connection.extended_seq);
+            piggyback_ack(connection, packet);
+
+            fec_tag tag{};
+            auto protect = connection.fec && connection.fec->tx_tag(tag);
+
+            if (protect) {
+                packet.set_fec_option(tag);
+            }
+
+            copy_payload(connection, packet, in_flight);
+
+            // never exceed the window with the last segment
+            if (packet.size() > window - in_flight) {
+                packet.set_size(static_cast<uint16_t>(window - in_flight));
+            }
+
+            if (protect) {
+                connection.fec->sent(connection.tx_next_seq_num, packet.payload(), packet.size());
+            }
+
+            connection.tx_next_seq_num += packet.size();
+
+            connection.rtt_start(connection.tx_next_seq_num, tx_time);
+
+            // repair packets cover the uncompressed segment
+            compress_payload(connection, packet, in_flight);
+
+            break;
+        }
+        case State::FinWait: {
+            if (!timer_expired) {
+                return false;
+            }
+
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num - 1, connection.extended_seq);
+            packet.set_flags(Flag::Fin);
+
+            break;
+        }
+        case State::Closing: {
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num++, connection.extended_seq);
+            packet.set_flags(Flag::Fin);
+
+            connection.state = State::FinWait;
+
+            connection.close_at = Time::get_time_in_ms() + Config::TIMEWAIT * 1000;
+
+            break;
+        }
+        case State::CloseWait: {
+            return false;
+        }
+        case State::LastAck: {
+            if (!timer_expired) {
+                return false;
+            }
+
+            packet.initialize(connection.src_port, connection.dst_port, connection.tx_next_seq_num - 1, connection.extended_seq);
+            packet.set_ack_num(connection.rx_acked);
+            packet.set_flags(Flag::Fin | Flag::Ack);
+
+            if (connection.close_at < Time::get_time_in_ms()) {
+                // cool-off time exceeded, connection closed
+                connection.state = State::Closed;
+            }
+
+            break;
+        }
+        case State::TimeWait: {
+            if (connection.close_at < Time::get_time_in_ms()) {
+                // cool-off time exceeded, connection closed
+                connection.state = State::Closed;
+            }
+
+            connection.tx_last_time = Time::get_time_in_ms();
+
+            return false;
+        }
+        case State::Fountain: {
+            if (!tx_fountain(connection, packet)) {
+                return false;
+            }
+
+            break;
+        }
+        default:
+            error("this should not happen");
+    }
+
+    connection.tx_last_time = tx_time;
+
+    return true;
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::create_connection(uint8_t *buffer, size_t len, uint8_t rx_port, uint8_t tx_port) -> Connection * {
+    return connections.create_connection(buffer, len, rx_port, tx_port, *this);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::destroy_connection(Connection *connection) -> bool {
+    // the connection may be destroyed already
+    if (!connections.contains(connection)) {
+        return false;
+    }
+
+    if (connection->state != State::Closed && connection->state != State::Listen) {
+        return false;
+    }
+
+    // the connection must not stay queued in the inbox
+    drain_inbox();
+
+    ready_connections.remove(connection);
+    timer_connections.remove(connection);
+    ack_connections.remove(connection);
+    progressed_connections.remove(connection);
+
+    return connections.destroy_connection(connection);
+}
+
+template<typename Config>
+auto BasicTcpEndpoint<Config>::tx_ready(Connection &connection) -> bool {
+    switch (connection.state) {
+        case State::Closed:
+            return connection.tx_data_to_send() || connection.connect_requested;
+        case State::Established:
+            return connection.tx_retransmitting() || (connection.fec && connection.fec->repair_pending()) ||
+                   (connection.tx_data_to_send() && connection.tx_data_in_flight() < tx_window(connection));
+        case State::Closing:
+            return true;
+        case State::Fountain:
+            return connection.fountain_encoder != nullptr;
+        default:
+            // all other states only transmit on expiry of the TX timer
+            return false;
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::schedule(Connection &connection) {
+    timer_connections.remove(&connection);
+
+    if (connection.tx_timer_running()) {
+        timer_connections.insert(&connection, connection.tx_timer_deadline());
+    }
+
+    if (tx_ready(connection)) {
+        ready_connections.push_back(&connection);
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::progressed(Connection &connection) {
+    if (track_progress) {
+        progressed_connections.push_back(&connection);
+    }
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::notify(Connection &connection) {
+    auto head = inbox.load(std::memory_order_relaxed);
+
+    do {
+        connection.inbox_next = head;
+    } while (!inbox.compare_exchange_weak(head, &connection, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<typename Config>
+void BasicTcpEndpoint<Config>::drain_inbox() {
+    auto connection = inbox.exchange(nullptr, std::memory_order_acquire);
+
+    // the inbox is a stack, reverse it to keep the order of notifications
+    Connection *ordered = nullptr;
+
+    while (connection) {
+        auto next = connection->inbox_next;
+        connection->inbox_next = ordered;
+        ordered = connection;
+        connection = next;
+    }
+
+    while (ordered) {
+        auto next = ordered->inbox_next;
+
+        // notifications from now on queue the connection again
+        ordered->notified.store(false, std::memory_order_release);
+
+        ordered->window_opened();
+        schedule(*ordered);
+
+        ordered = next;
+    }
+}
+
+template<typename Config>
+void BasicConnection<Config>::notify_endpoint() {
+    if (!notified.exchange(true, std::memory_order_acq_rel)) {
+        endpoint.notify(*this);
+    }
+}
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_ENDPOINT_IMPL_HPP
@@ -0,0 +1,381 @@
+#ifndef SPACE_TCP_FEC_HPP
+#define SPACE_TCP_FEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "space_tcp/sequence.hpp"
+
+namespace space_tcp {
+
+/// Position of a segment in the code. Data segments are numbered by `index`
+/// within their group, repair segments by the lane they protect.
+struct fec_tag {
+    uint16_t group;
+    uint8_t index;
+    uint8_t lanes;      // repair segments of the group
+};
+
+/// Forward error correction with an interleaved XOR code. The data segments
+/// a connection sends are grouped, every group of `data` segments is followed
+/// by `repair` repair segments. Data segment `i` of a group belongs to lane
+/// `i % repair` and the repair segment of a lane is the XOR of its data
+/// segments, i.e., the receiver rebuilds one lost segment per lane without
+/// waiting for a retransmission. Interleaving spreads bursts of up to
+/// `repair` consecutive losses across the lanes.
+///
+/// Both hosts of a connection need an instance, which is owned by the
+/// application and must not be shared between connections. The buffer holds
+/// the XOR of each lane of the group sent and of the last two groups
+/// received, i.e., it should hold at least 3 * repair * mss bytes. Lanes of
+/// segments larger than their share of the buffer are not protected.
+///
+/// Keeping two groups while receiving covers repair segments which arrive
+/// after data segments of the next group, e.g., if they are reordered on the
+/// link or retransmitted data segments of a group follow its repair
+/// segments. Repair segments of older groups are ignored.
+class ForwardErrorCorrection {
+public:
+    /// Maximum number of data segments per group.
+    static constexpr size_t MAX_GROUP_SIZE = 16;
+
+    /// Maximum number of data segments protected by one repair segment.
+    static constexpr size_t MAX_LANE_SEGMENTS = 8;
+
+    /// Groups without retransmission before an adaptive code drops a repair
+    /// segment.
+    static constexpr size_t ADAPTATION_GROUPS = 8;
+
+    /// Repair segment of a completed group, built by the sender.
+    struct repair_segment {
+        fec_tag tag;
+        seq_range segments[MAX_LANE_SEGMENTS];  // data segments of the lane
+        size_t count;
+        const uint8_t *payload;                 // XOR of the data segments
+        size_t len;
+    };
+
+    static auto create(uint8_t *buffer, size_t len) -> ForwardErrorCorrection {
+        return {buffer, len};
+    }
+
+    /// Sends `repair` repair segments per `data` data segments, starting with
+    /// the next group. A repair segment protects at most MAX_LANE_SEGMENTS
+    /// data segments, no repair segments disable the code.
+    void set_code_rate(size_t data, size_t repair) {
+        data = (data < MAX_GROUP_SIZE) ? data : MAX_GROUP_SIZE;
+        repair = (repair < data) ? repair : data;
+
+        if (repair > 0 && (data + repair - 1) / repair > MAX_LANE_SEGMENTS) {
+            repair = (data + MAX_LANE_SEGMENTS - 1) / MAX_LANE_SEGMENTS;
+        }
+
+        data_count = data;
+        repair_count = repair;
+    }
+
+    /// Returns the number of data segments per group.
+    [[nodiscard]] auto data_segments() const -> size_t {
+        return data_count;
+    }
+
+    /// Returns the number of repair segments per group.
+    [[nodiscard]] auto repair_segments() const -> size_t {
+        return repair_count;
+    }
+
+    /// Adapts the number of repair segments to the losses the code does not
+    /// cover: groups which required retransmissions add a repair segment,
+    /// every ADAPTATION_GROUPS groups without retransmission remove one.
+    void set_adaptive(bool adaptive) {
+        this->adaptive = adaptive;
+        clean_groups = 0;
+    }
+
+    /// Returns whether data segments are protected.
+    [[nodiscard]] auto enabled() const -> bool {
+        return data_count > 0 && repair_count > 0;
+    }
+
+    /// Stores the tag of the next data segment in `tag`. Returns false if the
+    /// segment is sent unprotected.
+    auto tx_tag(fec_tag &tag) -> bool {
+        if (tx_pending > 0) {
+            return false;
+        }
+
+        // the code rate is fixed for a whole group
+        if (tx_index == 0) {
+            if (!enabled()) {
+                return false;
+            }
+
+            tx_data = data_count;
+            tx_lanes = repair_count;
+            tx_state.reset(tx_lanes, len / 3);
+        }
+
+        tag = {tx_group, static_cast<uint8_t>(tx_index), static_cast<uint8_t>(tx_lanes)};
+
+        return true;
+    }
+
+    /// Adds the data segment `seq` with `len` bytes of `payload`, tagged by
+    /// tx_tag(), to the current group. Once the group is complete, its repair
+    /// segments are pending.
+    void sent(uint32_t seq, const uint8_t *payload, size_t len) {
+        tx_state.add(tx_buffer(), tx_index % tx_lanes, payload, len);
+        tx_segments[tx_index] = {seq, seq + static_cast<uint32_t>(len)};
+
+        if (++tx_index < tx_data) {
+            return;
+        }
+
+        tx_pending = tx_lanes;
+
+        if (adaptive) {
+            adapt();
+        }
+    }
+
+    /// Returns whether repair segments of a completed group are pending.
+    [[nodiscard]] auto repair_pending() const -> bool {
+        return tx_pending > 0;
+    }
+
+    /// Stores the next pending repair segment in `repair`. Returns false if
+    /// no repair segment is pending.
+    auto next_repair(repair_segment &repair) -> bool {
+        while (tx_pending > 0) {
+            auto lane = tx_lanes - tx_pending;
+            auto group = tx_group;
+
+            // the next data segment starts a new group
+            if (--tx_pending == 0) {
+                tx_index = 0;
+                tx_group++;
+            }
+
+            // segments too large for the lane
+            if (tx_state.broken & (1u << lane)) {
+                continue;
+            }
+
+            repair.tag = {group, static_cast<uint8_t>(lane), static_cast<uint8_t>(tx_lanes)};
+            repair.count = 0;
+
+            for (auto i = lane; i < tx_data; i += tx_lanes) {
+                repair.segments[repair.count++] = tx_segments[i];
+            }
+
+            repair.payload = tx_buffer() + lane * tx_state.lane_len;
+            repair.len = tx_state.used[lane];
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Called for each retransmitted segment, i.e., a loss the code did not
+    /// cover.
+    void retransmitted() {
+        tx_retransmitted++;
+    }
+
+    /// Adds the received data segment `tag` with `len` bytes of `payload` to
+    /// the XOR of its lane.
+    void received(const fec_tag &tag, const uint8_t *payload, size_t len) {
+        if (tag.lanes == 0 || tag.lanes > MAX_GROUP_SIZE || tag.index >= MAX_GROUP_SIZE) {
+            return;
+        }
+
+        // groups alternate between the two receive states
+        auto &group = rx_groups[tag.group & 1];
+
+        if (!group.active || tag.group != group.group || tag.lanes != group.state.lanes) {
+            // segments of a group older than the one stored are too late
+            if (group.active && static_cast<int16_t>(tag.group - group.group) < 0) {
+                return;
+            }
+
+            // first segment of a new group, replaces the group before the
+            // previous one
+            group.active = true;
+            group.group = tag.group;
+            group.received = 0;
+            group.state.reset(tag.lanes, this->len / 3);
+        }
+
+        // XOR twice would remove the segment again
+        if (group.received & (1u << tag.index)) {
+            return;
+        }
+
+        group.received |= 1u << tag.index;
+
+        group.state.add(rx_buffer(tag.group), tag.index % tag.lanes, payload, len);
+    }
+
+    /// Rebuilds the only missing data segment covered by the repair segment
+    /// `tag`, whose data segments are given by `segments`, in `payload`. The
+    /// payload holds the `len` bytes of the repair segment, the rebuilt
+    /// segment is stored at its start. Returns the position of the rebuilt
+    /// segment in `segments`, `count` if no segment can be rebuilt.
+    auto recover(const fec_tag &tag, const seq_range *segments, size_t count, uint8_t *payload, size_t len) -> size_t {
+        if (count == 0 || tag.lanes == 0 || tag.index >= tag.lanes) {
+            return count;
+        }
+
+        auto &group = rx_groups[tag.group & 1];
+        auto known = group.active && tag.group == group.group;
+
+        // a lane of a single segment repeats it
+        if (count == 1 && !known) {
+            return 0;
+        }
+
+        if (!known || tag.lanes != group.state.lanes || (group.state.broken & (1u << tag.index))) {
+            return count;
+        }
+
+        auto missing = count;
+
+        for (size_t i = 0; i < count; i++) {
+            auto index = tag.index + i * tag.lanes;
+
+            if (index >= MAX_GROUP_SIZE) {
+                return count;
+            }
+
+            if (group.received & (1u << index)) {
+                continue;
+            }
+
+            // more than one segment lost
+            if (missing != count) {
+                return count;
+            }
+
+            missing = i;
+        }
+
+        if (missing == count || group.state.used[tag.index] > len) {
+            return count;
+        }
+
+        auto lane = rx_buffer(tag.group) + tag.index * group.state.lane_len;
+
+        for (size_t i = 0; i < group.state.used[tag.index]; i++) {
+            payload[i] ^= lane[i];
+        }
+
+        group.received |= 1u << (tag.index + missing * tag.lanes);
+        recovered_segments++;
+
+        return missing;
+    }
+
+    /// Returns the number of data segments rebuilt from repair segments.
+    [[nodiscard]] auto recovered() const -> size_t {
+        return recovered_segments;
+    }
+
+private:
+    ForwardErrorCorrection(uint8_t *buffer, size_t len) : buffer{buffer}, len{len} {};
+
+    // XOR of the lanes of a group, in one third of the buffer
+    struct lane_state {
+        size_t lanes;
+        size_t lane_len;
+        size_t used[MAX_GROUP_SIZE];    // bytes of each lane in use
+        uint32_t broken;                // lanes with segments exceeding lane_len
+
+        void reset(size_t lanes, size_t part) {
+            this->lanes = lanes;
+            lane_len = part / lanes;
+            broken = 0;
+
+            for (auto &bytes : used) {
+                bytes = 0;
+            }
+        }
+
+        void add(uint8_t *buffer, size_t lane, const uint8_t *payload, size_t len) {
+            if (len > lane_len) {
+                broken |= 1u << lane;
+                return;
+            }
+
+            auto data = buffer + lane * lane_len;
+
+            // lanes are zeroed lazily as they grow
+            if (len > used[lane]) {
+                memset(data + used[lane], 0, len - used[lane]);
+                used[lane] = len;
+            }
+
+            for (size_t i = 0; i < len; i++) {
+                data[i] ^= payload[i];
+            }
+        }
+    };
+
+    [[nodiscard]] auto tx_buffer() const -> uint8_t * {
+        return buffer;
+    }
+
+    [[nodiscard]] auto rx_buffer(uint16_t group) const -> uint8_t * {
+        return buffer + len / 3 * (1 + (group & 1));
+    }
+
+    void adapt() {
+        if (tx_retransmitted > 0) {
+            set_code_rate(data_count, repair_count + 1);
+            clean_groups = 0;
+        } else if (++clean_groups >= ADAPTATION_GROUPS && repair_count > 1) {
+            set_code_rate(data_count, repair_count - 1);
+            clean_groups = 0;
+        }
+
+        tx_retransmitted = 0;
+    }
+
+    uint8_t *buffer;
+    size_t len;
+
+    size_t data_count{};
+    size_t repair_count{};
+
+    bool adaptive{};
+    size_t clean_groups{};
+
+    // group currently sent
+    uint16_t tx_group{};
+    size_t tx_index{};
+    size_t tx_data{};
+    size_t tx_lanes{1};
+    size_t tx_pending{};                // repair segments left to send
+    size_t tx_retransmitted{};
+    seq_range tx_segments[MAX_GROUP_SIZE]{};
+    lane_state tx_state{};
+
+    // group received
+    struct rx_group_state {
+        bool active;
+        uint16_t group;
+        uint32_t received;              // data segments received or rebuilt
+        lane_state state;
+    };
+
+    // current and previous group received, indexed by the lowest bit of the
+    // group number
+    rx_group_state rx_groups[2]{};
+
+    size_t recovered_segments{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_FEC_HPP
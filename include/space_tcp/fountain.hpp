@@ -0,0 +1,253 @@
+#ifndef SPACE_TCP_FOUNTAIN_HPP
+#define SPACE_TCP_FOUNTAIN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "space_tcp/log.hpp"
+
+namespace space_tcp {
+
+// Random linear fountain code over GF(2). An object is split into blocks of
+// the symbol size, symbol `id` is the XOR of the blocks selected by the bits
+// of a coefficient vector derived from `id`. The first symbols are the
+// blocks themselves, i.e., a transfer without loss needs no decoding. Any
+// set of symbols with linearly independent coefficients, usually a few more
+// symbols than blocks, rebuilds the object.
+
+/// Maximum number of blocks of a fountain-coded object.
+constexpr size_t FOUNTAIN_MAX_BLOCKS = 64;
+
+/// Returns the coefficient vector of symbol `id` of an object of `blocks`
+/// blocks, bit `i` selects block `i`.
+inline auto fountain_coefficients(uint32_t id, size_t blocks) -> uint64_t {
+    if (id < blocks) {
+        return uint64_t{1} << id;
+    }
+
+    // splitmix64, sender and receiver derive the same vector from the id
+    uint64_t z = id + 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    z ^= z >> 31;
+
+    if (blocks < FOUNTAIN_MAX_BLOCKS) {
+        z &= (uint64_t{1} << blocks) - 1;
+    }
+
+    return z ? z : uint64_t{1} << (id % blocks);
+}
+
+/// Encodes an object in symbols of a fountain code.
+class FountainEncoder {
+public:
+    /// Creates an encoder for the `len` bytes of `object`, which must not
+    /// change while it is sent, in symbols of `symbol_size` bytes. Objects
+    /// are limited to FOUNTAIN_MAX_BLOCKS symbols, the encoder of a larger
+    /// object has no blocks, i.e., it cannot be sent.
+    static auto create(const uint8_t *object, size_t len, size_t symbol_size) -> FountainEncoder {
+        if (symbol_size > 0 && len > FOUNTAIN_MAX_BLOCKS * symbol_size) {
+            warn("object exceeds " << FOUNTAIN_MAX_BLOCKS << " fountain symbols and cannot be sent");
+            len = 0;
+        }
+
+        return {object, len, symbol_size};
+    }
+
+    /// Returns the size of the object (bytes).
+    [[nodiscard]] auto object_size() const -> size_t {
+        return len;
+    }
+
+    /// Returns the size of the symbols (bytes).
+    [[nodiscard]] auto symbol_size() const -> size_t {
+        return symbol_len;
+    }
+
+    /// Returns the number of blocks of the object, i.e., the least number of
+    /// symbols to rebuild it.
+    [[nodiscard]] auto blocks() const -> size_t {
+        return symbol_len ? (len + symbol_len - 1) / symbol_len : 0;
+    }
+
+    /// Stores symbol `id` in `buffer`, which must hold symbol_size() bytes.
+    /// Returns the size of the symbol.
+    auto symbol(uint32_t id, uint8_t *buffer) const -> size_t {
+        if (blocks() == 0) {
+            return 0;
+        }
+
+        auto coefficients = fountain_coefficients(id, blocks());
+
+        memset(buffer, 0, symbol_len);
+
+        for (size_t b = 0; b < blocks(); b++) {
+            if (!(coefficients & (uint64_t{1} << b))) {
+                continue;
+            }
+
+            // the last block is padded with zeros
+            auto block = object + b * symbol_len;
+            auto block_len = (len - b * symbol_len < symbol_len) ? len - b * symbol_len : symbol_len;
+
+            for (size_t i = 0; i < block_len; i++) {
+                buffer[i] ^= block[i];
+            }
+        }
+
+        return symbol_len;
+    }
+
+private:
+    FountainEncoder(const uint8_t *object, size_t len, size_t symbol_size) : object{object}, len{len},
+                                                                            symbol_len{symbol_size} {};
+
+    const uint8_t *object;
+    size_t len;
+    size_t symbol_len;
+};
+
+/// Rebuilds an object from symbols of a fountain code by Gaussian
+/// elimination as the symbols arrive. Symbol `i` is reduced by the symbols
+/// received before and stored as row `i` of the buffer, once all rows are
+/// present the buffer holds the object.
+class FountainDecoder {
+public:
+    /// Creates a decoder which rebuilds the object in `buffer`. The buffer
+    /// should hold the object rounded up to a multiple of the symbol size.
+    static auto create(uint8_t *buffer, size_t len) -> FountainDecoder {
+        return {buffer, len};
+    }
+
+    /// Adds symbol `id` of an object of `object_size` bytes, the symbol is
+    /// `len` bytes of `symbol`. The symbol is used as scratch space. Returns
+    /// whether the symbol brought the decoder closer to the object.
+    auto add(uint32_t id, size_t object_size, uint8_t *symbol, size_t len) -> bool {
+        if (complete()) {
+            return false;
+        }
+
+        // the first symbol determines the layout of the object
+        if (blocks == 0) {
+            if (len == 0 || object_size == 0) {
+                return false;
+            }
+
+            auto count = (object_size + len - 1) / len;
+
+            if (count > FOUNTAIN_MAX_BLOCKS || count * len > buffer_len) {
+                warn("fountain-coded object exceeds the decoder buffer");
+                return false;
+            }
+
+            object_len = object_size;
+            symbol_len = len;
+            blocks = count;
+        } else if (object_size != object_len || len != symbol_len) {
+            return false;
+        }
+
+        auto coefficients = fountain_coefficients(id, blocks);
+
+        for (size_t b = 0; b < blocks; b++) {
+            auto bit = uint64_t{1} << b;
+
+            if (!(coefficients & bit)) {
+                continue;
+            }
+
+            if (!(pivots & bit)) {
+                rows[b] = coefficients;
+                memcpy(row(b), symbol, len);
+
+                pivots |= bit;
+
+                if (++rank == blocks) {
+                    solve();
+                }
+
+                return true;
+            }
+
+            // eliminate block b with the row holding it
+            coefficients ^= rows[b];
+
+            auto data = row(b);
+            for (size_t i = 0; i < len; i++) {
+                symbol[i] ^= data[i];
+            }
+        }
+
+        // linearly dependent on the symbols received before
+        return false;
+    }
+
+    /// Returns whether the object is rebuilt, i.e., the buffer holds it.
+    [[nodiscard]] auto complete() const -> bool {
+        return blocks > 0 && rank == blocks;
+    }
+
+    /// Returns the size of the object (bytes), 0 until the first symbol
+    /// arrived.
+    [[nodiscard]] auto object_size() const -> size_t {
+        return object_len;
+    }
+
+    /// Returns the number of linearly independent symbols received.
+    [[nodiscard]] auto received_symbols() const -> size_t {
+        return rank;
+    }
+
+    /// Forgets all symbols, e.g., to receive the next object.
+    void reset() {
+        object_len = 0;
+        symbol_len = 0;
+        blocks = 0;
+        rank = 0;
+        pivots = 0;
+    }
+
+private:
+    FountainDecoder(uint8_t *buffer, size_t len) : buffer{buffer}, buffer_len{len} {};
+
+    [[nodiscard]] auto row(size_t i) const -> uint8_t * {
+        return buffer + i * symbol_len;
+    }
+
+    // back substitution, row i only holds blocks i and above
+    void solve() {
+        for (auto b = blocks; b-- > 0;) {
+            for (auto j = b + 1; j < blocks; j++) {
+                if (!(rows[b] & (uint64_t{1} << j))) {
+                    continue;
+                }
+
+                rows[b] ^= rows[j];
+
+                auto data = row(b);
+                auto other = row(j);
+
+                for (size_t i = 0; i < symbol_len; i++) {
+                    data[i] ^= other[i];
+                }
+            }
+        }
+    }
+
+    uint8_t *buffer;
+    size_t buffer_len;
+
+    size_t object_len{};
+    size_t symbol_len{};
+    size_t blocks{};
+
+    // coefficients of the rows, the lowest bit of row i is bit i
+    uint64_t rows[FOUNTAIN_MAX_BLOCKS]{};
+    uint64_t pivots{};
+    size_t rank{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_FOUNTAIN_HPP
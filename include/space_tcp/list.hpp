@@ -0,0 +1,143 @@
+#ifndef SPACE_TCP_LIST_HPP
+#define SPACE_TCP_LIST_HPP
+
+#include <cstddef>
+
+namespace space_tcp {
+
+/// Links of an element in an intrusive list. An element needs one hook per
+/// list it can be part of.
+template<typename T>
+struct ListHook {
+    T *prev{};
+    T *next{};
+    bool linked{};
+};
+
+/// Doubly linked list which stores its links in the elements themselves, i.e.,
+/// inserting and removing elements never allocates memory and takes O(1).
+template<typename T, ListHook<T> T::*Hook>
+class IntrusiveList {
+public:
+    /// Returns whether the list is empty.
+    [[nodiscard]] auto empty() const -> bool {
+        return head == nullptr;
+    }
+
+    /// Returns the number of elements in the list.
+    [[nodiscard]] auto size() const -> size_t {
+        return elements;
+    }
+
+    /// Returns the first element of the list or `nullptr` if the list is empty.
+    [[nodiscard]] auto front() const -> T * {
+        return head;
+    }
+
+    /// Returns the last element of the list or `nullptr` if the list is empty.
+    [[nodiscard]] auto back() const -> T * {
+        return tail;
+    }
+
+    /// Returns whether `element` is linked into a list with this hook.
+    static auto contains(const T *element) -> bool {
+        return (element->*Hook).linked;
+    }
+
+    /// Returns the predecessor of `element` or `nullptr`.
+    static auto prev(const T *element) -> T * {
+        return (element->*Hook).prev;
+    }
+
+    /// Returns the successor of `element` or `nullptr`.
+    static auto next(const T *element) -> T * {
+        return (element->*Hook).next;
+    }
+
+    /// Appends `element` to the list. Returns false if the element is already
+    /// linked.
+    auto push_back(T *element) -> bool {
+        return insert_before(nullptr, element);
+    }
+
+    /// Inserts `element` in front of `position`. A `position` of `nullptr`
+    /// appends the element. Returns false if the element is already linked.
+    auto insert_before(T *position, T *element) -> bool {
+        auto &hook = element->*Hook;
+
+        if (hook.linked) {
+            return false;
+        }
+
+        auto prev = position ? (position->*Hook).prev : tail;
+
+        hook.prev = prev;
+        hook.next = position;
+        hook.linked = true;
+
+        if (prev) {
+            (prev->*Hook).next = element;
+        } else {
+            head = element;
+        }
+
+        if (position) {
+            (position->*Hook).prev = element;
+        } else {
+            tail = element;
+        }
+
+        elements++;
+
+        return true;
+    }
+
+    /// Unlinks `element` from the list. Returns false if the element is not
+    /// linked.
+    auto remove(T *element) -> bool {
+        auto &hook = element->*Hook;
+
+        if (!hook.linked) {
+            return false;
+        }
+
+        if (hook.prev) {
+            (hook.prev->*Hook).next = hook.next;
+        } else {
+            head = hook.next;
+        }
+
+        if (hook.next) {
+            (hook.next->*Hook).prev = hook.prev;
+        } else {
+            tail = hook.prev;
+        }
+
+        hook = {};
+
+        elements--;
+
+        return true;
+    }
+
+    /// Unlinks and returns the first element of the list or `nullptr` if the
+    /// list is empty.
+    auto pop_front() -> T * {
+        auto element = head;
+
+        if (element) {
+            remove(element);
+        }
+
+        return element;
+    }
+
+private:
+    T *head{};
+    T *tail{};
+    size_t elements{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_LIST_HPP
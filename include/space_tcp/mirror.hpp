@@ -0,0 +1,54 @@
+#ifndef SPACE_TCP_MIRROR_HPP
+#define SPACE_TCP_MIRROR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Memory mapped twice in a row on Linux, i.e., byte `i + size()` is byte
+/// `i`. Ring buffers created with RingBuffer::create_mirrored() on top of it
+/// see all data and free space as contiguous. The mapping is set up once and
+/// released with the instance, which can be moved but not copied.
+class MirroredMemory {
+public:
+    /// Maps at least `len` bytes twice, rounded up to the page size. Returns
+    /// an instance without memory, see valid(), if the system does not
+    /// support the mapping.
+    static auto create(size_t len) -> MirroredMemory;
+
+    MirroredMemory(const MirroredMemory &) = delete;
+    auto operator=(const MirroredMemory &) -> MirroredMemory & = delete;
+
+    MirroredMemory(MirroredMemory &&other) noexcept;
+    auto operator=(MirroredMemory &&other) noexcept -> MirroredMemory &;
+
+    ~MirroredMemory();
+
+    /// Returns whether the memory is mapped.
+    [[nodiscard]] auto valid() const -> bool {
+        return memory != nullptr;
+    }
+
+    /// Returns the first mapping, the second one follows right behind it.
+    [[nodiscard]] auto data() const -> uint8_t * {
+        return memory;
+    }
+
+    /// Returns the size of one mapping (bytes).
+    [[nodiscard]] auto size() const -> size_t {
+        return len;
+    }
+
+private:
+    MirroredMemory(uint8_t *memory, size_t len) : memory{memory}, len{len} {};
+
+    void release();
+
+    uint8_t *memory;
+    size_t len;
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_MIRROR_HPP
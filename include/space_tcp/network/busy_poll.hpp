@@ -0,0 +1,105 @@
+#ifndef SPACE_TCP_BUSY_POLL_HPP
+#define SPACE_TCP_BUSY_POLL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Statistics of a busy-polling network interface.
+struct busy_poll_stats {
+    /// Packets received while spinning.
+    uint64_t spin_hits;
+    /// Spin budgets that ran out without a packet.
+    uint64_t spin_misses;
+    /// Times the interface fell back to sleeping.
+    uint64_t sleeps;
+    /// Total time spent spinning (us).
+    uint64_t spin_time;
+};
+
+/// Spin budget of a busy-polling network interface. The budget follows the
+/// recent packet inter-arrival times, i.e., an interface spins about twice
+/// the average gap between packets, but never longer than `max_budget`.
+class BusyPoller {
+public:
+    /// Creates a busy poller which spins at most `max_budget` us. A maximum
+    /// budget of 0 disables busy polling.
+    static auto create(size_t max_budget) -> BusyPoller {
+        return BusyPoller{max_budget};
+    }
+
+    /// Returns whether busy polling is enabled.
+    [[nodiscard]] auto enabled() const -> bool {
+        return max_budget > 0;
+    }
+
+    /// Returns the current spin budget (us).
+    [[nodiscard]] auto budget() const -> size_t {
+        if (!enabled()) {
+            return 0;
+        }
+
+        // without samples, spin the full budget
+        if (last_arrival == 0) {
+            return max_budget;
+        }
+
+        auto budget = 2 * average_gap;
+
+        // spin at least a fraction of the maximum budget to catch bursts
+        if (budget < max_budget / 16) {
+            budget = max_budget / 16;
+        }
+
+        return (budget > max_budget) ? max_budget : budget;
+    }
+
+    /// Records the arrival of a packet at `time` (us).
+    void packet_arrived(uint64_t time) {
+        if (last_arrival != 0) {
+            auto gap = time - last_arrival;
+
+            // exponentially weighted moving average with a weight of 1/8
+            average_gap = average_gap - average_gap / 8 + gap / 8;
+        }
+
+        last_arrival = time;
+    }
+
+    /// Records a spin of `duration` us which received a packet if `hit`.
+    void spun(uint64_t duration, bool hit) {
+        stats.spin_time += duration;
+
+        if (hit) {
+            stats.spin_hits++;
+        } else {
+            stats.spin_misses++;
+        }
+    }
+
+    /// Records that the interface went to sleep.
+    void slept() {
+        stats.sleeps++;
+    }
+
+    /// Returns the busy polling statistics.
+    [[nodiscard]] auto statistics() const -> busy_poll_stats {
+        return stats;
+    }
+
+private:
+    explicit BusyPoller(size_t max_budget) : max_budget{max_budget} {};
+
+    size_t max_budget;
+
+    // average packet inter-arrival time (us)
+    uint64_t average_gap{};
+    uint64_t last_arrival{};
+
+    busy_poll_stats stats{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_BUSY_POLL_HPP
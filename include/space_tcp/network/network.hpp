@@ -6,17 +6,75 @@
 
 namespace space_tcp {
 
+/// A packet to be handed to the network.
+struct network_buffer {
+    const uint8_t *data;
+    size_t len;
+};
+
 /// Interface for the stack used below S3TP, e.g., IPv4+TUN. For RODOS, this
 /// interface is yet to be implemented, e.g., Nanolink+Topics.
 class NetworkInterface {
 public:
     virtual ~NetworkInterface() = default;
 
+    /// Returns the largest S3TP packet (bytes) the underlying network carries
+    /// without fragmentation. Returns 0 if the network does not know its MTU,
+    /// endpoints then use the payload size of their configuration.
+    virtual auto mtu() -> size_t {
+        return 0;
+    }
+
+    /// Returns the rate (bytes per second) at which the underlying network
+    /// takes packets without dropping them, e.g., the data rate of a radio
+    /// modem. Returns 0 if the rate is unknown, endpoints then send packets
+    /// back to back.
+    virtual auto rate() -> uint64_t {
+        return 0;
+    }
+
     /// Receive up to `len` bytes into `buffer` from the underlying network.
     virtual auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t = 0;
 
+    /// Receive up to `max_packets` packets from the underlying network. Waits
+    /// up to `timeout` ms for the first packet only. Packet `i` is stored at
+    /// `buffer + i * slot_len` and its size in `lens[i]`. Returns the number
+    /// of packets received. Implementations should override this if the
+    /// network can drain its queue without waiting for each packet.
+    virtual auto receive_batch(uint8_t *buffer, size_t slot_len, size_t *lens, size_t max_packets,
+                               ssize_t timeout) -> size_t {
+        size_t received = 0;
+
+        while (received < max_packets) {
+            auto len = receive(buffer + received * slot_len, slot_len, (received == 0) ? timeout : 0);
+
+            if (len < 0) {
+                break;
+            }
+
+            lens[received++] = len;
+        }
+
+        return received;
+    }
+
     /// Send out `len` bytes from `buffer` via the underlying network.
     virtual auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t = 0;
+
+    /// Send out `count` packets via the underlying network. Returns the number
+    /// of packets sent. Implementations should override this with a vectored
+    /// send if the network supports one.
+    virtual auto send_batch(const network_buffer *packets, size_t count, ssize_t timeout) -> size_t {
+        size_t sent = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            if (send(packets[i].data, packets[i].len, timeout) >= 0) {
+                sent++;
+            }
+        }
+
+        return sent;
+    }
 };
 
 }  // namespace space_tcp
@@ -1,6 +1,7 @@
 #ifndef SPACE_TCP_TUN_HPP
 #define SPACE_TCP_TUN_HPP
 
+#include "busy_poll.hpp"
 #include "network.hpp"
 
 #include <cstring>
@@ -22,6 +23,9 @@ struct tun_config {
     const std::string &dev_name{};
     const std::string &source_addr{"10.0.6.1"};
     const std::string &dest_addr{"10.0.7.1"};
+    /// Maximum time (us) to spin on the device before sleeping, 0 disables
+    /// busy polling.
+    size_t busy_poll{0};
 };
 
 /// IPv4 + Linux TUN interface which implements the NetworkInterface.
@@ -30,22 +34,62 @@ public:
     // buffer should have the (maximum) size of one S3TP packet + header of the network protocol
     static auto create(uint8_t *buffer, size_t len, const tun_config &config = {}) -> TunInterface;
 
+    /// Creates an interface on the TUN device opened as `fd`, e.g., a
+    /// persistent device or one handed over by a privileged process. The
+    /// device name in `config` is ignored.
+    static auto attach(int fd, uint8_t *buffer, size_t len, const tun_config &config = {}) -> TunInterface;
+
+    /// Returns the MTU of the TUN device minus the IPv4 header, limited by the
+    /// size of the interface buffer.
+    auto mtu() -> size_t override;
+
     auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override;
 
+    auto receive_batch(uint8_t *buffer, size_t slot_len, size_t *lens, size_t max_packets,
+                       ssize_t timeout) -> size_t override;
+
     auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override;
 
+    auto send_batch(const network_buffer *packets, size_t count, ssize_t timeout) -> size_t override;
+
+    /// Enables busy polling with a spin budget of at most `max_budget` us. The
+    /// interface spins on the non-blocking device for about twice the recent
+    /// packet inter-arrival time before it sleeps. A budget of 0 disables busy
+    /// polling.
+    void set_busy_poll(size_t max_budget);
+
+    /// Returns spin versus sleep statistics of busy polling.
+    [[nodiscard]] auto busy_poll_statistics() const -> busy_poll_stats;
+
 private:
-    TunInterface(std::string name, int fd, uint8_t *const buffer, size_t len, uint32_t source_addr, uint32_t dest_addr)
+    TunInterface(std::string name, int fd, size_t device_mtu, uint8_t *const buffer, size_t len, uint32_t source_addr,
+                 uint32_t dest_addr, size_t busy_poll)
             : name{std::move(name)},
               fd{fd},
+              device_mtu{device_mtu},
               tun_buffer{buffer},
               buffer_len{len},
               src_addr{source_addr},
-              dst_addr{dest_addr} {};
+              dst_addr{dest_addr},
+              poller{BusyPoller::create(busy_poll)} {};
+
+    /// Receives the next S3TP packet into `buffer`, spinning first if busy
+    /// polling is enabled. Packets dropped by read_packet() do not end the
+    /// wait. Returns the size of the packet or -1 on timeout.
+    auto wait_packet(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t;
+
+    /// Waits up to `timeout` ms until the TUN device is readable.
+    auto wait_readable(ssize_t timeout) -> bool;
+
+    /// Reads one packet from the TUN device and copies the contained S3TP
+    /// packet to `buffer`. Returns the size of the S3TP packet, 0 if the
+    /// packet was dropped or -1 if no packet was queued.
+    auto read_packet(uint8_t *buffer, size_t len) -> ssize_t;
 
     // TUN device
     const std::string name;
     const int fd;
+    const size_t device_mtu;
 
     // transmit/receive buffer
     uint8_t *const tun_buffer;
@@ -57,6 +101,9 @@ private:
 
     // IPv4 identification number
     uint16_t identification{0x1337};
+
+    // busy polling of the receive path
+    BusyPoller poller;
 };
 
 }  // namespace space_tcp
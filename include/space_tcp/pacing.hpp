@@ -0,0 +1,95 @@
+#ifndef SPACE_TCP_PACING_HPP
+#define SPACE_TCP_PACING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Token bucket spacing packets to a configured rate. The bucket holds up to
+/// `burst` bytes which are sent back to back, afterwards packets leave at
+/// `rate` bytes per second. A packet may be sent as long as the bucket is not
+/// in debt, i.e., a packet larger than the tokens left delays the next one.
+class TokenBucket {
+public:
+    /// Creates a token bucket for `rate` bytes per second and bursts of
+    /// `burst` bytes. A rate of 0 disables pacing.
+    static auto create(uint64_t rate, size_t burst) -> TokenBucket {
+        return TokenBucket{rate, burst};
+    }
+
+    /// Returns whether pacing is enabled.
+    [[nodiscard]] auto enabled() const -> bool {
+        return rate > 0;
+    }
+
+    /// Returns the rate of the bucket (bytes per second).
+    [[nodiscard]] auto get_rate() const -> uint64_t {
+        return rate;
+    }
+
+    /// Returns whether a packet may be sent at `time` (us).
+    auto ready(uint64_t time) -> bool {
+        refill(time);
+
+        return tokens >= 0;
+    }
+
+    /// Takes `bytes` sent at `time` (us) from the bucket.
+    void consume(size_t bytes, uint64_t time) {
+        if (!enabled()) {
+            return;
+        }
+
+        refill(time);
+
+        tokens -= static_cast<int64_t>(bytes) * SCALE;
+    }
+
+    /// Returns the time (us) at which the next packet may be sent, `time` if
+    /// a packet may be sent right away.
+    auto release_time(uint64_t time) -> uint64_t {
+        if (ready(time)) {
+            return time;
+        }
+
+        auto debt = static_cast<uint64_t>(-tokens);
+
+        return time + (debt + rate - 1) / rate;
+    }
+
+private:
+    TokenBucket(uint64_t rate, size_t burst) : rate{rate}, capacity{static_cast<int64_t>(burst) * SCALE},
+                                               tokens{capacity} {};
+
+    void refill(uint64_t time) {
+        if (!enabled() || time <= last_time) {
+            return;
+        }
+
+        auto elapsed = time - last_time;
+        last_time = time;
+
+        // refilling beyond the capacity is pointless and might overflow
+        auto missing = static_cast<uint64_t>(capacity - tokens);
+        elapsed = (elapsed > missing / rate + 1) ? missing / rate + 1 : elapsed;
+
+        tokens += static_cast<int64_t>(elapsed * rate);
+        tokens = (tokens > capacity) ? capacity : tokens;
+    }
+
+    // tokens are counted in millionths of a byte, i.e., a rate of 1 B/s adds
+    // one token per microsecond
+    static constexpr int64_t SCALE = 1000000;
+
+    uint64_t rate;
+    int64_t capacity;
+    int64_t tokens;
+
+    // time of the last refill (us)
+    uint64_t last_time{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_PACING_HPP
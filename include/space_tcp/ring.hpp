@@ -1,30 +1,104 @@
 #ifndef SPACE_TCP_RING_HPP
 #define SPACE_TCP_RING_HPP
 
+#include <atomic>
 #include <cstdint>
+#include <cstring>
 
 namespace space_tcp {
 
+/// Size of a cache line (bytes), state written by different threads is kept
+/// this far apart.
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/// Contiguous bytes, e.g., one of the two parts of data wrapping around the
+/// end of a ring buffer.
+struct region {
+    uint8_t *data;
+    size_t len;
+};
+
+/// Contiguous bytes which are only read.
+struct const_region {
+    const uint8_t *data;
+    size_t len;
+};
+
+/// Ring buffer of bytes. Head and tail count the bytes ever pushed and popped,
+/// i.e., they never wrap and the buffer is full once they are `capacity()`
+/// apart. Data is moved with at most two memcpy()s, one per side of the end
+/// of the buffer, and buffers of a power-of-two size map counters to indices
+/// by masking.
+///
+/// The buffer is a lock-free single-producer/single-consumer queue: one
+/// thread may push (push_back(), advance_head(), writable()) while another
+/// one pops (pop_front(), copy(), peek(), readable()). Each side publishes
+/// its counter with release semantics after moving the data and reads the
+/// counter of the other side with acquire semantics. The counters live on
+/// separate cache lines.
 class RingBuffer {
 public:
     /// Creates a new ring buffer.
     static auto create(uint8_t *buffer, size_t len) -> RingBuffer {
-        return {buffer, len};
+        return {buffer, len, false};
+    }
+
+    /// Creates a ring buffer whose `len` bytes at `buffer` are mapped a second
+    /// time right behind it, see MirroredMemory. Data wrapping around the end
+    /// of the buffer continues in the mirror, i.e., it is contiguous and
+    /// moved with a single memcpy().
+    static auto create_mirrored(uint8_t *buffer, size_t len) -> RingBuffer {
+        return {buffer, len, true};
+    }
+
+    /// Copies the buffer, neither side may use it meanwhile.
+    RingBuffer(const RingBuffer &other) : buffer{other.buffer}, len{other.len}, mask{other.mask},
+                                          mirrored{other.mirrored},
+                                          head{other.head.load(std::memory_order_relaxed)},
+                                          tail{other.tail.load(std::memory_order_relaxed)} {}
+
+    /// Copies the buffer, neither side may use it meanwhile.
+    auto operator=(const RingBuffer &other) -> RingBuffer & {
+        buffer = other.buffer;
+        len = other.len;
+        mask = other.mask;
+        mirrored = other.mirrored;
+        head.store(other.head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        tail.store(other.tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        return *this;
+    }
+
+    /// Returns the size of the buffer.
+    [[nodiscard]] auto capacity() const -> size_t {
+        return len;
     }
 
     /// Returns the number of free bytes in the buffer.
     [[nodiscard]] auto free_space() const -> size_t {
-        return (tail == head && !full) ? len : (tail - head) % len;
+        return len - used_space();
     }
 
     /// Returns the number of used bytes in the buffer.
     [[nodiscard]] auto used_space() const -> size_t {
-        return len - free_space();
+        return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+
+    /// Returns the number of bytes ever pushed to the buffer, i.e., it grows
+    /// whenever data is added.
+    [[nodiscard]] auto pushed() const -> uint64_t {
+        return head.load(std::memory_order_acquire);
+    }
+
+    /// Returns the number of bytes ever popped from the buffer, i.e., it
+    /// grows whenever space is freed.
+    [[nodiscard]] auto popped() const -> uint64_t {
+        return tail.load(std::memory_order_acquire);
     }
 
     /// Returns whether the ring buffer is empty.
     [[nodiscard]] auto empty() const -> bool {
-        return free_space() == len;
+        return used_space() == 0;
     }
 
     /// Pushes data to the ring buffer.
@@ -34,27 +108,21 @@ public:
             return -1;
         }
 
+        if (offset >= free_space()) {
+            return 0;
+        }
+
         if (len + offset > free_space()) {
             len = free_space() - offset;
         }
 
-        // ring buffer location to put data
-        auto cur_head = (head + offset) % this->len;
+        auto position = head.load(std::memory_order_relaxed);
 
-        // copy data to into ring buffer
-        for (size_t i = 0; i < len; i++) {
-            buffer[cur_head] = data[i];
-            cur_head = (cur_head + 1) % this->len;
-        }
+        write(position + offset, data, len);
 
         // update head if data was put into the front
         if (offset == 0) {
-            head = cur_head;
-
-            // is the buffer full now?
-            if (len > 0 && head == tail) {
-                full = true;
-            }
+            head.store(position + len, std::memory_order_release);
         }
 
         return len;
@@ -66,18 +134,13 @@ public:
             len = used_space();
         }
 
+        auto position = tail.load(std::memory_order_relaxed);
+
         if (data) {
-            for (size_t i = 0; i < len; i++) {
-                data[i] = buffer[tail];
-                tail = (tail + 1) % this->len;
-            }
-        } else {
-            tail = (tail + len) % this->len;
+            read(position, data, len);
         }
 
-        if (full && len > 0) {
-            full = false;
-        }
+        tail.store(position + len, std::memory_order_release);
 
         return len;
     }
@@ -88,35 +151,130 @@ public:
             return false;
         }
 
-        head = (head + bytes) % len;
+        head.store(head.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
 
         return true;
     }
 
     /// Copies data from the ring buffer to `buffer`.
     auto copy(uint8_t *buffer, size_t len, size_t offset = 0) -> size_t {
-        len = (len + offset > used_space()) ? used_space() : len;
+        if (offset > used_space()) {
+            return 0;
+        }
+
+        len = (len + offset > used_space()) ? used_space() - offset : len;
 
-        auto index = (tail + offset) % this->len;
+        read(tail.load(std::memory_order_relaxed) + offset, buffer, len);
 
-        for (size_t i = 0; i < len; i++) {
-            buffer[i] = this->buffer[index];
-            index = (index + 1) % this->len;
+        return len;
+    }
+
+    /// Returns the used data starting `offset` bytes into the buffer without
+    /// copying it. Data wrapping around the end of the buffer is returned in
+    /// two parts, i.e., `len` is set to the contiguous bytes at the returned
+    /// pointer, which may be less than the used data.
+    auto peek(size_t offset, size_t &len) const -> const uint8_t * {
+        if (offset >= used_space()) {
+            len = 0;
+            return nullptr;
         }
 
+        auto position = tail.load(std::memory_order_relaxed) + offset;
+
+        len = contiguous(position, used_space() - offset);
+
+        return buffer + index(position);
+    }
+
+    /// Stores up to `len` bytes of free space, starting at the head, in
+    /// `regions`. Space wrapping around the end of the buffer is split into
+    /// two regions, unused regions are empty. Returns the bytes stored,
+    /// advance_head() makes data written to them part of the buffer.
+    auto writable(region (&regions)[2], size_t len) -> size_t {
+        len = (len < free_space()) ? len : free_space();
+
+        auto position = head.load(std::memory_order_relaxed);
+        auto first = contiguous(position, len);
+
+        regions[0] = {buffer + index(position), first};
+        regions[1] = {buffer, len - first};
+
+        return len;
+    }
+
+    /// Stores the used data, starting at the tail, in `regions`. Data
+    /// wrapping around the end of the buffer is split into two regions,
+    /// unused regions are empty. Returns the bytes stored, pop_front() with
+    /// nullptr releases them.
+    auto readable(const_region (&regions)[2]) const -> size_t {
+        auto len = used_space();
+        auto position = tail.load(std::memory_order_relaxed);
+        auto first = contiguous(position, len);
+
+        regions[0] = {buffer + index(position), first};
+        regions[1] = {buffer, len - first};
+
         return len;
     }
 
 private:
-    RingBuffer(uint8_t *buffer, size_t len) : buffer{buffer}, len{len} {};
+    RingBuffer(uint8_t *buffer, size_t len, bool mirrored) : buffer{buffer}, len{len},
+                                                             mask{(len > 1 && (len & (len - 1)) == 0) ? len - 1 : 0},
+                                                             mirrored{mirrored} {};
+
+    // position of the byte with counter `counter` in the buffer
+    [[nodiscard]] auto index(uint64_t counter) const -> size_t {
+        if (mask || len < 2) {
+            return static_cast<size_t>(counter & mask);
+        }
+
+        return static_cast<size_t>(counter % len);
+    }
+
+    // bytes of `len` starting at `counter` before the end of the buffer
+    [[nodiscard]] auto contiguous(uint64_t counter, size_t len) const -> size_t {
+        if (mirrored) {
+            return len;
+        }
+
+        auto before_end = this->len - index(counter);
+
+        return (len < before_end) ? len : before_end;
+    }
+
+    void write(uint64_t counter, const uint8_t *data, size_t len) {
+        auto first = contiguous(counter, len);
+
+        if (first > 0) {
+            memcpy(buffer + index(counter), data, first);
+        }
+
+        if (len > first) {
+            memcpy(buffer, data + first, len - first);
+        }
+    }
+
+    void read(uint64_t counter, uint8_t *data, size_t len) const {
+        auto first = contiguous(counter, len);
+
+        if (first > 0) {
+            memcpy(data, buffer + index(counter), first);
+        }
+
+        if (len > first) {
+            memcpy(data + first, buffer, len - first);
+        }
+    }
 
     uint8_t *buffer;
     size_t len;
+    size_t mask;        // len - 1 if len is a power of two, else 0
 
-    size_t head{}; // producer index
-    size_t tail{}; // consumer index
+    // the buffer is mapped a second time behind itself
+    bool mirrored;
 
-    bool full{false};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head{};  // bytes ever pushed, producer counter
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail{};  // bytes ever popped, consumer counter
 };
 
 }  // namespace space_tcp
@@ -0,0 +1,481 @@
+#ifndef SPACE_TCP_RUNNER_HPP
+#define SPACE_TCP_RUNNER_HPP
+
+#include "endpoint.hpp"
+#include "log.hpp"
+#include "time.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace space_tcp {
+
+/// Readiness events of a connection driven by an EndpointRunner.
+enum class Event : uint8_t {
+    None = 0x0,
+    /// Data arrived in the receive buffer.
+    Readable = 0x1,
+    /// Space was freed in the transmit buffer.
+    Writable = 0x2,
+    /// The state of the connection changed.
+    StateChange = 0x4,
+};
+
+/// OR operator to combine events.
+inline auto operator|(Event a, Event b) -> Event {
+    return static_cast<Event>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+}
+
+/// AND operator to check whether an event occurred.
+inline auto operator&(Event a, Event b) -> Event {
+    return static_cast<Event>(static_cast<uint8_t>(a) & static_cast<uint8_t>(b));
+}
+
+/// Drives an endpoint configured by `Config` on a stack thread of its own,
+/// i.e., applications neither call rx()/tx() nor poll connections. Up to `S`
+/// connections can be watched: the runner tells about their progress through
+/// one eventfd per connection, see watch(), which fits into poll()/epoll()
+/// loops, and offers blocking send() and receive() calls with timeouts.
+///
+/// The stack thread waits for packets at most `max_wait` ms before it picks
+/// up data queued by the application, calls of the application which are
+/// not thread-safe run on the stack thread via call(). Linux only.
+template<typename Config, typename std::size_t S>
+class BasicEndpointRunner {
+public:
+    using TcpEndpoint = BasicTcpEndpoint<Config>;
+    using Connection = BasicConnection<Config>;
+
+    /// Creates a runner and starts its stack thread, which drives `endpoint`
+    /// from now on. The runner cannot be moved.
+    static auto create(TcpEndpoint &endpoint, size_t max_wait = 10) -> BasicEndpointRunner {
+        return {endpoint, max_wait};
+    }
+
+    BasicEndpointRunner(const BasicEndpointRunner &) = delete;
+    auto operator=(const BasicEndpointRunner &) -> BasicEndpointRunner & = delete;
+
+    /// Stops the stack thread and closes the eventfds of all watched
+    /// connections.
+    ~BasicEndpointRunner() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            running = false;
+        }
+
+        condition.notify_all();
+        stack_thread.join();
+
+        for (auto &watch : watches) {
+            if (watch.connection) {
+                ::close(watch.fd);
+            }
+        }
+    }
+
+    /// Runs `function` on the stack thread and waits until it returns, e.g.,
+    /// to create, listen on, close or destroy connections. The function must
+    /// not wait for the runner.
+    template<typename F>
+    void call(F &&function) {
+        if (std::this_thread::get_id() == stack_thread.get_id()) {
+            function();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{mutex};
+
+        // one call at a time
+        condition.wait(lock, [this] { return !pending_call; });
+
+        pending_call = [](void *context) {
+            (*static_cast<std::remove_reference_t<F> *>(context))();
+        };
+        pending_context = &function;
+
+        auto served = calls_served;
+        condition.wait(lock, [this, served] { return calls_served != served; });
+    }
+
+    /// Watches `connection` for readiness events. Returns an eventfd which
+    /// becomes readable once events are pending, see events(), or -1 if the
+    /// runner watches `S` connections already.
+    auto watch(Connection *connection) -> int {
+        int fd = -1;
+
+        call([this, connection, &fd] {
+            for (auto &watch : watches) {
+                if (watch.connection.load(std::memory_order_relaxed) == connection) {
+                    fd = watch.fd;
+                    return;
+                }
+            }
+
+            for (auto &watch : watches) {
+                if (watch.connection.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+
+                fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+                if (fd < 0) {
+                    warn("failed to create eventfd for connection");
+                    return;
+                }
+
+                watch.fd = fd;
+                watch.received = connection->receive_buffer.pushed();
+                watch.released = connection->transmit_buffer.popped();
+                watch.state.store(connection->state, std::memory_order_relaxed);
+                watch.opened = connection->state != State::Closed;
+                watch.finished.store(false, std::memory_order_relaxed);
+
+                // the connection starts out with what it can do right now
+                auto events = Event::StateChange;
+                events = connection->receive_buffer.empty() ? events : events | Event::Readable;
+                events = (connection->transmit_buffer.free_space() == 0) ? events : events | Event::Writable;
+                watch.events.store(static_cast<uint8_t>(events), std::memory_order_relaxed);
+
+                watch.connection.store(connection, std::memory_order_release);
+                signal(watch);
+
+                return;
+            }
+        });
+
+        return fd;
+    }
+
+    /// Stops watching `connection` and closes its eventfd. No thread may
+    /// wait for the connection meanwhile.
+    void unwatch(Connection *connection) {
+        call([this, connection] {
+            auto watch = find(connection);
+
+            if (watch) {
+                watch->connection.store(nullptr, std::memory_order_release);
+                ::close(watch->fd);
+            }
+        });
+    }
+
+    /// Returns and clears the events pending for the watched `connection`.
+    /// The eventfd of the connection should be read before, such that it
+    /// signals later events again.
+    auto events(Connection *connection) -> Event {
+        auto watch = find(connection);
+
+        return watch ? take(*watch, Event::Readable | Event::Writable | Event::StateChange) : Event::None;
+    }
+
+    /// Returns the state of the watched `connection` as of the last events.
+    auto state(Connection *connection) -> State {
+        auto watch = find(connection);
+
+        return watch ? watch->state.load(std::memory_order_acquire) : State::Closed;
+    }
+
+    /// Waits up to `timeout` ms, forever if negative, for one of `events` of
+    /// the watched `connection`. Returns and clears the events which occurred.
+    auto wait(Connection *connection, Event events, ssize_t timeout = -1) -> Event {
+        auto watch = find(connection);
+
+        if (!watch) {
+            warn("connection is not watched by the runner");
+            return Event::None;
+        }
+
+        auto occurred = Event::None;
+
+        wait_until(deadline(timeout), [&] {
+            occurred = take(*watch, events);
+            return occurred != Event::None;
+        });
+
+        return occurred;
+    }
+
+    /// Copies `len` bytes of `data` to the transmit buffer of the watched
+    /// `connection`, waiting for free space up to `timeout` ms, forever if
+    /// negative. Returns early once the connection is closed. Returns the
+    /// bytes copied or -1 if the connection is not watched.
+    auto send(Connection *connection, const uint8_t *data, size_t len, ssize_t timeout = -1) -> ssize_t {
+        auto watch = find(connection);
+
+        if (!watch) {
+            warn("connection is not watched by the runner");
+            return -1;
+        }
+
+        auto until = deadline(timeout);
+        size_t sent = 0;
+
+        while (true) {
+            const_region remaining{data + sent, len - sent};
+            sent += connection->send(&remaining, 1);
+
+            if (sent == len || !sending(*watch)) {
+                return sent;
+            }
+
+            auto space = wait_until(until, [&] {
+                return connection->transmit_buffer.free_space() > 0 || !sending(*watch);
+            });
+
+            if (!space) {
+                return sent;
+            }
+        }
+    }
+
+    /// Copies up to `len` bytes received by the watched `connection` to
+    /// `buffer`, waiting for data up to `timeout` ms, forever if negative.
+    /// Returns the bytes copied, 0 on timeout or once the remote host closed
+    /// the connection, or -1 if the connection is not watched.
+    auto receive(Connection *connection, uint8_t *buffer, size_t len, ssize_t timeout = -1) -> ssize_t {
+        auto watch = find(connection);
+
+        if (!watch) {
+            warn("connection is not watched by the runner");
+            return -1;
+        }
+
+        auto until = deadline(timeout);
+
+        while (true) {
+            region destination{buffer, len};
+            auto received = connection->receive(&destination, 1);
+
+            if (received > 0 || len == 0 || !receiving(*watch)) {
+                return received;
+            }
+
+            auto data = wait_until(until, [&] {
+                return !connection->receive_buffer.empty() || !receiving(*watch);
+            });
+
+            if (!data) {
+                return 0;
+            }
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // progress of a watched connection
+    struct Watch {
+        std::atomic<Connection *> connection{};
+        int fd{-1};
+
+        // events not taken by the application yet
+        std::atomic<uint8_t> events{};
+
+        // state as of the last events and whether the connection was closed
+        // after it had been opened
+        std::atomic<State> state{State::Closed};
+        std::atomic<bool> finished{};
+
+        // counters of the buffers and whether the connection left `Closed`
+        // as of the last events, stack thread only
+        uint64_t received{};
+        uint64_t released{};
+        bool opened{};
+    };
+
+    BasicEndpointRunner(TcpEndpoint &endpoint, size_t max_wait) : endpoint{endpoint}, max_wait{max_wait} {
+        stack_thread = std::thread{[this] { run(); }};
+    };
+
+    void run() {
+        while (true) {
+            if (!serve_call()) {
+                return;
+            }
+
+            endpoint.tx_burst(Config::BURST_SIZE);
+
+            // wait for packets until the next packet is due to be sent
+            auto now = Time::get_time_in_ms();
+            auto next = endpoint.next_deadline();
+            auto timeout = static_cast<ssize_t>(max_wait);
+
+            if (next <= now) {
+                timeout = 0;
+            } else if (next - now < max_wait) {
+                timeout = static_cast<ssize_t>(next - now);
+            }
+
+            endpoint.rx_burst(Config::BURST_SIZE, timeout);
+
+            update_watches();
+        }
+    }
+
+    // runs the pending call, returns false once the runner stops
+    auto serve_call() -> bool {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (pending_call) {
+            pending_call(pending_context);
+
+            pending_call = nullptr;
+            calls_served++;
+
+            condition.notify_all();
+        }
+
+        return running;
+    }
+
+    // turns the progress of watched connections into events
+    void update_watches() {
+        auto progress = false;
+
+        for (auto &watch : watches) {
+            auto connection = watch.connection.load(std::memory_order_relaxed);
+
+            if (!connection) {
+                continue;
+            }
+
+            auto events = Event::None;
+
+            auto received = connection->receive_buffer.pushed();
+            auto released = connection->transmit_buffer.popped();
+
+            if (received != watch.received) {
+                watch.received = received;
+                events = events | Event::Readable;
+            }
+
+            if (released != watch.released) {
+                watch.released = released;
+                events = events | Event::Writable;
+            }
+
+            if (connection->state != watch.state.load(std::memory_order_relaxed)) {
+                if (connection->state != State::Closed) {
+                    watch.opened = true;
+                } else if (watch.opened) {
+                    watch.finished.store(true, std::memory_order_relaxed);
+                }
+
+                watch.state.store(connection->state, std::memory_order_release);
+                events = events | Event::StateChange;
+            }
+
+            if (events != Event::None) {
+                watch.events.fetch_or(static_cast<uint8_t>(events), std::memory_order_release);
+                signal(watch);
+                progress = true;
+            }
+        }
+
+        // waiters check their condition under the lock, i.e., they either
+        // saw the progress or wait for the notification already
+        if (progress) {
+            { std::lock_guard<std::mutex> lock{mutex}; }
+            condition.notify_all();
+        }
+    }
+
+    static void signal(Watch &watch) {
+        uint64_t one = 1;
+
+        // fails only with the counter at its maximum, i.e., readable anyway
+        [[maybe_unused]] auto written = ::write(watch.fd, &one, sizeof(one));
+    }
+
+    static auto take(Watch &watch, Event events) -> Event {
+        auto mask = static_cast<uint8_t>(events);
+
+        return static_cast<Event>(watch.events.fetch_and(static_cast<uint8_t>(~mask), std::memory_order_acquire) & mask);
+    }
+
+    auto find(Connection *connection) -> Watch * {
+        for (auto &watch : watches) {
+            if (connection && watch.connection.load(std::memory_order_acquire) == connection) {
+                return &watch;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // data may still arrive unless the remote host closed the connection
+    static auto receiving(const Watch &watch) -> bool {
+        auto state = watch.state.load(std::memory_order_acquire);
+
+        return !watch.finished.load(std::memory_order_relaxed) && state != State::CloseWait &&
+               state != State::LastAck && state != State::TimeWait;
+    }
+
+    // data may still be sent unless this host closed the connection
+    static auto sending(const Watch &watch) -> bool {
+        auto state = watch.state.load(std::memory_order_acquire);
+
+        return !watch.finished.load(std::memory_order_relaxed) && state != State::Closing &&
+               state != State::FinWait && state != State::TimeWait && state != State::LastAck;
+    }
+
+    static auto deadline(ssize_t timeout) -> Clock::time_point {
+        return (timeout < 0) ? Clock::time_point::max() : Clock::now() + std::chrono::milliseconds(timeout);
+    }
+
+    // waits for `predicate` until `until`, returns whether it holds
+    template<typename P>
+    auto wait_until(Clock::time_point until, P predicate) -> bool {
+        std::unique_lock<std::mutex> lock{mutex};
+
+        // predicates may take events, i.e., they are not evaluated again
+        auto holds = false;
+        auto done = [&] {
+            holds = predicate();
+            return holds || !running;
+        };
+
+        if (until == Clock::time_point::max()) {
+            condition.wait(lock, done);
+        } else {
+            condition.wait_until(lock, until, done);
+        }
+
+        return holds;
+    }
+
+    TcpEndpoint &endpoint;
+    size_t max_wait;
+
+    Watch watches[S];
+
+    // guards calls, waiters sleep on the condition until the stack thread
+    // served their call or made progress
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running{true};
+
+    // call waiting for the stack thread
+    void (*pending_call)(void *){};
+    void *pending_context{};
+    uint64_t calls_served{};
+
+    std::thread stack_thread;
+};
+
+/// A runner watching up to `S` connections of an endpoint with the default
+/// configuration.
+template<typename std::size_t S>
+using EndpointRunner = BasicEndpointRunner<DefaultConfig, S>;
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_RUNNER_HPP
@@ -8,13 +8,19 @@ struct segment {
     size_t len;
 };
 
+/// Set of up to `S` segments, e.g., data received out of order. Empty slots
+/// have a length of 0.
 template<typename std::size_t S>
 class Segments {
 public:
     auto insert(size_t offset, size_t len) -> bool {
+        if (len == 0) {
+            return false;
+        }
+
         if (stored_segments < S) {
-            for (auto i = 0; i < S; i++) {
-                if (segments[i].offset != 0) {
+            for (size_t i = 0; i < S; i++) {
+                if (segments[i].len != 0) {
                     continue;
                 }
 
@@ -35,8 +41,8 @@ public:
     }
 
     auto remove(size_t offset, size_t len) -> bool {
-        if (stored_segments > 0) {
-            for (auto i = 0; i < S; i++) {
+        if (stored_segments > 0 && len != 0) {
+            for (size_t i = 0; i < S; i++) {
                 if (segments[i].offset != offset || segments[i].len != len) {
                     continue;
                 }
@@ -63,15 +69,78 @@ public:
         return (stored_segments > 0);
     }
 
+    /// Returns whether the segment at `offset` with `len` bytes is stored.
+    auto contains(size_t offset, size_t len) -> bool {
+        for (size_t i = 0; i < S && len != 0; i++) {
+            if (segments[i].offset == offset && segments[i].len == len) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Stores up to `max` ranges covered by the stored segments in `ranges`,
+    /// ordered by offset. Overlapping and adjacent segments are merged into
+    /// one range. Returns the number of ranges.
+    auto ranges(segment *ranges, size_t max) -> size_t {
+        size_t count = 0;
+        size_t end = 0;
+
+        while (count < max) {
+            // next segment starting at or after the end of the last range
+            auto next = S;
+
+            for (size_t i = 0; i < S; i++) {
+                if (segments[i].len == 0 || (count > 0 && segments[i].offset < end)) {
+                    continue;
+                }
+
+                if (next == S || segments[i].offset < segments[next].offset) {
+                    next = i;
+                }
+            }
+
+            if (next == S) {
+                break;
+            }
+
+            auto range = segments[next];
+
+            // grow the range by all segments overlapping or touching it
+            for (auto grown = true; grown;) {
+                grown = false;
+
+                for (size_t i = 0; i < S; i++) {
+                    auto segment_end = segments[i].offset + segments[i].len;
+
+                    if (segments[i].len != 0 && segments[i].offset <= range.offset + range.len &&
+                        segment_end > range.offset + range.len) {
+                        range.len = segment_end - range.offset;
+                        grown = true;
+                    }
+                }
+            }
+
+            ranges[count++] = range;
+            end = range.offset + range.len;
+        }
+
+        return count;
+    }
+
     auto get_smallest_offset_segment() -> segment {
         return segments[smallest_offset_index];
     }
 
 private:
     auto update_smallest_offset() {
-        auto smallest_offset = -1;
-        for (auto i = 0; i < S; i++) {
-            if (segments[i].offset > 0 && segments[i].offset < smallest_offset) {
+        auto found = false;
+        size_t smallest_offset = 0;
+
+        for (size_t i = 0; i < S; i++) {
+            if (segments[i].len != 0 && (!found || segments[i].offset < smallest_offset)) {
+                found = true;
                 smallest_offset = segments[i].offset;
                 smallest_offset_index = i;
             }
@@ -0,0 +1,56 @@
+#ifndef SPACE_TCP_SEQUENCE_HPP
+#define SPACE_TCP_SEQUENCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace space_tcp {
+
+// Serial number arithmetic (RFC 1982) for sequence and acknowledgment
+// numbers. Sequence numbers wrap around, i.e., `a` is smaller than `b` if `b`
+// lies less than half the sequence space ahead of `a`.
+
+/// Returns whether sequence number `a` precedes `b`.
+template<typename T>
+constexpr auto seq_lt(T a, T b) -> bool {
+    static_assert(std::is_unsigned_v<T>, "sequence numbers must be unsigned");
+    return static_cast<std::make_signed_t<T>>(static_cast<T>(a - b)) < 0;
+}
+
+/// Returns whether sequence number `a` precedes or equals `b`.
+template<typename T>
+constexpr auto seq_leq(T a, T b) -> bool {
+    return a == b || seq_lt(a, b);
+}
+
+/// Returns whether sequence number `a` follows `b`.
+template<typename T>
+constexpr auto seq_gt(T a, T b) -> bool {
+    return seq_lt(b, a);
+}
+
+/// Returns whether sequence number `a` follows or equals `b`.
+template<typename T>
+constexpr auto seq_geq(T a, T b) -> bool {
+    return a == b || seq_lt(b, a);
+}
+
+/// Range [start, end) of sequence numbers.
+struct seq_range {
+    uint32_t start;
+    uint32_t end;
+};
+
+/// Maximum number of ranges reported in a selective acknowledgment.
+constexpr size_t MAX_SACK_BLOCKS = 4;
+
+/// Extends the 16-bit sequence number `seq` of a packet to the 32-bit
+/// sequence number closest to `reference`.
+constexpr auto seq_extend(uint16_t seq, uint32_t reference) -> uint32_t {
+    return reference + static_cast<uint32_t>(static_cast<int16_t>(static_cast<uint16_t>(seq - reference)));
+}
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_SEQUENCE_HPP
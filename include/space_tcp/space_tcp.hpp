@@ -2,12 +2,16 @@
 #define SPACE_TCP_HPP
 
 #include "network/tun.hpp"
+#include "connection/slab_connections.hpp"
 #include "endpoint.hpp"
+#include "coroutine.hpp"
 
 #include <cstdint>
 
 #ifndef __rodos__
 
+#include "runner.hpp"
+
 #include <cstdlib>
 #include <iostream>
 
@@ -32,18 +36,27 @@ auto create_topic_socket(uint8_t (&buffer)[S]) {
 
 #endif
 
-/// Creates a S3TP endpoint.
-template<typename std::size_t S, std::size_t C>
-auto create_tcp_endpoint(uint8_t (&buffer)[S], NetworkInterface &network, Connections<C> &connections) -> TcpEndpoint {
-    return TcpEndpoint::create(&*buffer, S, connections, network);
+/// Creates a S3TP endpoint. The configuration of the endpoint follows the
+/// configuration of its connection storage.
+template<typename std::size_t S, typename Config>
+auto create_tcp_endpoint(uint8_t (&buffer)[S], NetworkInterface &network,
+                         BasicConnectionManager<Config> &connections) -> BasicTcpEndpoint<Config> {
+    return BasicTcpEndpoint<Config>::create(&*buffer, S, connections, network);
 }
 
 /// Creates a connection for a S3TP endpoint.
-template<typename std::size_t S>
-auto create_connection(uint8_t (&buffer)[S], uint8_t rx_port, uint8_t tx_port, TcpEndpoint &endpoint) -> Connection * {
+template<typename std::size_t S, typename Config>
+auto create_connection(uint8_t (&buffer)[S], uint8_t rx_port, uint8_t tx_port,
+                       BasicTcpEndpoint<Config> &endpoint) -> BasicConnection<Config> * {
     return endpoint.create_connection(buffer, S, rx_port, tx_port);
 }
 
+/// Destroys a closed connection of a S3TP endpoint.
+template<typename Config>
+auto destroy_connection(BasicConnection<Config> *connection, BasicTcpEndpoint<Config> &endpoint) -> bool {
+    return endpoint.destroy_connection(connection);
+}
+
 }  // namespace space_tcp
 
 #endif //SPACE_TCP_HPP
\ No newline at end of file
@@ -10,6 +10,10 @@ class Time {
 public:
     /// Returns milliseconds since the Unix epoch.
     static auto get_time_in_ms() -> uint64_t;
+
+    /// Returns microseconds of a monotonic clock, e.g., for measuring short
+    /// intervals.
+    static auto get_time_in_us() -> uint64_t;
 };
 
 }  // namespace space_tcp
@@ -0,0 +1,201 @@
+#ifndef SPACE_TCP_TIMER_HPP
+#define SPACE_TCP_TIMER_HPP
+
+#include "list.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace space_tcp {
+
+/// Position of an element in a timer wheel. An element needs one entry per
+/// wheel it can be part of, next to the hook linking it into a slot.
+struct TimerEntry {
+    // time (ms) at which the timer expires
+    uint64_t deadline{};
+
+    // time (ms) of the slot the element is stored in, the deadline or, for
+    // deadlines already passed on insertion, the time the wheel had reached
+    uint64_t slot_time{};
+};
+
+/// Hashed timing wheel of `S` slots with a resolution of 1 ms. An element is
+/// linked into the slot of its deadline modulo `S`, i.e., inserting and
+/// removing elements takes O(1) regardless of the order of deadlines.
+/// Expiring elements takes O(1) per element plus O(S / 64) per call to skip
+/// empty slots, deadlines more than `S` ms ahead stay in their slot until
+/// the wheel reaches them. Like IntrusiveList, the wheel never allocates
+/// memory.
+template<typename T, ListHook<T> T::*Hook, TimerEntry T::*Entry, size_t S>
+class TimerWheel {
+    static_assert(S >= 64 && (S & (S - 1)) == 0, "timer wheel needs a power of two of at least 64 slots");
+
+public:
+    /// Returns whether no element is in the wheel.
+    [[nodiscard]] auto empty() const -> bool {
+        return elements == 0;
+    }
+
+    /// Returns the number of elements in the wheel.
+    [[nodiscard]] auto size() const -> size_t {
+        return elements;
+    }
+
+    /// Returns whether `element` is in a wheel with this hook.
+    static auto contains(const T *element) -> bool {
+        return Slot::contains(element);
+    }
+
+    /// Inserts `element` to expire at `deadline` (ms). Returns false if the
+    /// element is already linked.
+    auto insert(T *element, uint64_t deadline) -> bool {
+        if (contains(element)) {
+            return false;
+        }
+
+        auto &entry = element->*Entry;
+        entry.deadline = deadline;
+        entry.slot_time = (deadline > cursor) ? deadline : cursor;
+
+        auto index = entry.slot_time & (S - 1);
+        slots[index].push_back(element);
+        occupied[index / 64] |= uint64_t{1} << (index % 64);
+        elements++;
+
+        return true;
+    }
+
+    /// Removes `element` from the wheel. Returns false if the element is not
+    /// linked.
+    auto remove(T *element) -> bool {
+        if (!contains(element)) {
+            return false;
+        }
+
+        unlink(element);
+
+        return true;
+    }
+
+    /// Removes and returns an element whose deadline is at or before `now`
+    /// (ms) or `nullptr` if no timer expired. Like the timers of a
+    /// connection, a timer expires once its deadline is reached.
+    auto pop_expired(uint64_t now) -> T * {
+        if (elements == 0) {
+            cursor = (now > cursor) ? now : cursor;
+            return nullptr;
+        }
+
+        // one turn of the wheel visits every slot
+        if (now > cursor + S) {
+            cursor = now - S;
+        }
+
+        // the slot of `now` is checked but not passed, later insertions may
+        // still expire at `now`
+        for (auto time = next_occupied(cursor, now); time <= now; time = next_occupied(time + 1, now)) {
+            cursor = time;
+
+            auto &slot = slots[time & (S - 1)];
+
+            for (auto element = slot.front(); element; element = Slot::next(element)) {
+                if ((element->*Entry).deadline <= now) {
+                    unlink(element);
+                    return element;
+                }
+            }
+        }
+
+        cursor = (now > cursor) ? now : cursor;
+
+        return nullptr;
+    }
+
+    /// Returns the earliest deadline (ms) in the wheel or `UINT64_MAX` if the
+    /// wheel is empty.
+    [[nodiscard]] auto earliest() const -> uint64_t {
+        auto deadline = UINT64_MAX;
+
+        if (elements == 0) {
+            return deadline;
+        }
+
+        // the first slot holding an element of the current turn holds the
+        // earliest deadline
+        auto last = cursor + S - 1;
+
+        for (auto time = next_occupied(cursor, last); time <= last; time = next_occupied(time + 1, last)) {
+            for (auto element = slots[time & (S - 1)].front(); element; element = Slot::next(element)) {
+                auto &entry = element->*Entry;
+
+                if (entry.slot_time <= time && entry.deadline < deadline) {
+                    deadline = entry.deadline;
+                }
+            }
+
+            if (deadline != UINT64_MAX) {
+                return deadline;
+            }
+        }
+
+        // all deadlines lie beyond the current turn
+        for (auto &slot : slots) {
+            for (auto element = slot.front(); element; element = Slot::next(element)) {
+                if ((element->*Entry).deadline < deadline) {
+                    deadline = (element->*Entry).deadline;
+                }
+            }
+        }
+
+        return deadline;
+    }
+
+private:
+    using Slot = IntrusiveList<T, Hook>;
+
+    void unlink(T *element) {
+        auto index = (element->*Entry).slot_time & (S - 1);
+
+        slots[index].remove(element);
+        elements--;
+
+        if (slots[index].empty()) {
+            occupied[index / 64] &= ~(uint64_t{1} << (index % 64));
+        }
+    }
+
+    // returns the first time in [from, last] whose slot holds elements or a
+    // time past `last` if there is none
+    [[nodiscard]] auto next_occupied(uint64_t from, uint64_t last) const -> uint64_t {
+        auto time = from;
+
+        while (time <= last) {
+            auto index = time & (S - 1);
+            auto bits = occupied[index / 64] >> (index % 64);
+
+            if (bits) {
+                for (; !(bits & 1); bits >>= 1) {
+                    time++;
+                }
+
+                return time;
+            }
+
+            time += 64 - index % 64;
+        }
+
+        return time;
+    }
+
+    Slot slots[S];
+    uint64_t occupied[S / 64]{};
+
+    // time (ms) up to which expired elements were removed
+    uint64_t cursor{};
+
+    size_t elements{};
+};
+
+}  // namespace space_tcp
+
+#endif //SPACE_TCP_TIMER_HPP
@@ -0,0 +1,87 @@
+#include "space_tcp/mirror.hpp"
+#include "space_tcp/log.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace space_tcp {
+
+auto MirroredMemory::create(size_t len) -> MirroredMemory {
+    auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    len = (len + page - 1) / page * page;
+
+    if (len == 0) {
+        return {nullptr, 0};
+    }
+
+    auto fd = memfd_create("space_tcp_ring", MFD_CLOEXEC);
+
+    if (fd < 0) {
+        warn("failed to create memory for a mirrored ring buffer");
+        return {nullptr, 0};
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(len)) < 0) {
+        warn("failed to size memory for a mirrored ring buffer");
+        close(fd);
+        return {nullptr, 0};
+    }
+
+    // reserve both halves first such that nothing else is mapped in between
+    auto reserved = mmap(nullptr, 2 * len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (reserved == MAP_FAILED) {
+        warn("failed to reserve address space for a mirrored ring buffer");
+        close(fd);
+        return {nullptr, 0};
+    }
+
+    auto memory = static_cast<uint8_t *>(reserved);
+
+    auto first = mmap(memory, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    auto second = mmap(memory + len, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+    // the mappings keep the memory alive
+    close(fd);
+
+    if (first == MAP_FAILED || second == MAP_FAILED) {
+        warn("failed to map memory of a mirrored ring buffer");
+        munmap(memory, 2 * len);
+        return {nullptr, 0};
+    }
+
+    return {memory, len};
+}
+
+MirroredMemory::MirroredMemory(MirroredMemory &&other) noexcept : memory{other.memory}, len{other.len} {
+    other.memory = nullptr;
+    other.len = 0;
+}
+
+auto MirroredMemory::operator=(MirroredMemory &&other) noexcept -> MirroredMemory & {
+    if (this != &other) {
+        release();
+
+        memory = other.memory;
+        len = other.len;
+
+        other.memory = nullptr;
+        other.len = 0;
+    }
+
+    return *this;
+}
+
+MirroredMemory::~MirroredMemory() {
+    release();
+}
+
+void MirroredMemory::release() {
+    if (memory) {
+        munmap(memory, 2 * len);
+        memory = nullptr;
+    }
+}
+
+}  // namespace space_tcp
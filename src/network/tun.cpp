@@ -3,37 +3,37 @@
 #include "protocol/ipv4.hpp"
 #include "space_tcp/space_tcp.hpp"
 
+#include <cerrno>
 #include <cstring>
 
 #include <fcntl.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <arpa/inet.h>
 
 namespace space_tcp {
 
-// buffer should have the (maximum) size of one S3TP packet + header of the network protocol
-auto TunInterface::create(uint8_t *buffer, size_t len, const tun_config &config) -> TunInterface {
+// converts an IPv4 address to host byte order
+static auto parse_address(const std::string &address) -> uint32_t {
     struct in_addr ip_addr{};
-    struct ifreq ifr{};
-    int fd;
 
-    // get all fields from config struct
-
-    if (!inet_pton(AF_INET, config.source_addr.c_str(), &ip_addr)) {
-        error("failed to convert IP address " << config.source_addr);
+    if (!inet_pton(AF_INET, address.c_str(), &ip_addr)) {
+        error("failed to convert IP address " << address);
     }
-    // inet_pton returns the address in network byte order -> ntohl
-    auto source_addr = ntohl(ip_addr.s_addr);
 
-    if (!inet_pton(AF_INET, config.dest_addr.c_str(), &ip_addr)) {
-        error("failed to convert IP address " << config.dest_addr);
-    }
     // inet_pton returns the address in network byte order -> ntohl
-    auto dest_addr = ntohl(ip_addr.s_addr);
+    return ntohl(ip_addr.s_addr);
+}
+
+// buffer should have the (maximum) size of one S3TP packet + header of the network protocol
+auto TunInterface::create(uint8_t *buffer, size_t len, const tun_config &config) -> TunInterface {
+    struct ifreq ifr{};
+    int fd;
 
     // open the clone device
     if ((fd = open("/dev/net/tun", O_RDWR)) < 0) {
@@ -53,10 +53,162 @@ auto TunInterface::create(uint8_t *buffer, size_t len, const tun_config &config)
         error("failed to create the tun device");
     }
 
-    return {ifr.ifr_name, fd, buffer, len, source_addr, dest_addr};
+    return attach(fd, buffer, len, config);
+}
+
+auto TunInterface::attach(int fd, uint8_t *buffer, size_t len, const tun_config &config) -> TunInterface {
+    // get all fields from config struct
+    auto source_addr = parse_address(config.source_addr);
+    auto dest_addr = parse_address(config.dest_addr);
+
+    // ask the kernel for the name and MTU of the device
+    struct ifreq ifr{};
+    size_t device_mtu = 1500;
+
+    if (ioctl(fd, TUNGETIFF, reinterpret_cast<void *>(&ifr)) < 0) {
+        warn("failed to get the name of the tun device, assuming an MTU of " << device_mtu << " bytes");
+    } else {
+        auto sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+        if (sock < 0 || ioctl(sock, SIOCGIFMTU, reinterpret_cast<void *>(&ifr)) < 0) {
+            warn("failed to get MTU of the tun device, assuming " << device_mtu << " bytes");
+        } else {
+            device_mtu = ifr.ifr_mtu;
+        }
+
+        if (sock >= 0) {
+            close(sock);
+        }
+    }
+
+    // reads must not block such that receive_batch() can drain the queue
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+        error("failed to make the tun device non-blocking");
+    }
+
+    return {ifr.ifr_name, fd, device_mtu, buffer, len, source_addr, dest_addr, config.busy_poll};
+}
+
+auto TunInterface::mtu() -> size_t {
+    auto mtu = (device_mtu < buffer_len) ? device_mtu : buffer_len;
+
+    // S3TP packets are sent in IPv4 packets without options
+    return (mtu > 20) ? mtu - 20 : 0;
 }
 
 auto TunInterface::receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t {
+    return wait_packet(buffer, len, timeout);
+}
+
+auto TunInterface::receive_batch(uint8_t *buffer, size_t slot_len, size_t *lens, size_t max_packets,
+                                 ssize_t timeout) -> size_t {
+    if (max_packets == 0) {
+        return 0;
+    }
+
+    auto first = wait_packet(buffer, slot_len, timeout);
+
+    if (first < 0) {
+        return 0;
+    }
+
+    lens[0] = first;
+
+    size_t received = 1;
+
+    // drain the queue of the TUN device without waiting again
+    while (received < max_packets) {
+        auto bytes = read_packet(buffer + received * slot_len, slot_len);
+
+        if (bytes < 0) {
+            break;
+        }
+
+        if (bytes > 0) {
+            lens[received++] = bytes;
+        }
+    }
+
+    return received;
+}
+
+void TunInterface::set_busy_poll(size_t max_budget) {
+    poller = BusyPoller::create(max_budget);
+}
+
+auto TunInterface::busy_poll_statistics() const -> busy_poll_stats {
+    return poller.statistics();
+}
+
+auto TunInterface::wait_packet(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t {
+    if (poller.enabled()) {
+        auto budget = poller.budget();
+
+        if (timeout != -1 && budget > static_cast<size_t>(timeout) * 1000) {
+            budget = timeout * 1000;
+        }
+
+        // spin on the non-blocking device before going to sleep
+        auto start = Time::get_time_in_us();
+        auto now = start;
+
+        do {
+            auto bytes = read_packet(buffer, len);
+
+            now = Time::get_time_in_us();
+
+            if (bytes > 0) {
+                poller.spun(now - start, true);
+                poller.packet_arrived(now);
+
+                return bytes;
+            }
+        } while (now - start < budget);
+
+        poller.spun(now - start, false);
+        poller.slept();
+
+        if (timeout != -1) {
+            auto spun = static_cast<ssize_t>((now - start) / 1000);
+            timeout = (spun < timeout) ? timeout - spun : 0;
+        }
+    }
+
+    auto deadline = (timeout == -1) ? UINT64_MAX : Time::get_time_in_ms() + timeout;
+
+    // dropped packets, e.g., of other protocols, do not end the wait
+    while (true) {
+        if (!wait_readable(timeout)) {
+            return -1;
+        }
+
+        ssize_t bytes;
+
+        do {
+            bytes = read_packet(buffer, len);
+        } while (bytes == 0);
+
+        if (bytes > 0) {
+            if (poller.enabled()) {
+                poller.packet_arrived(Time::get_time_in_us());
+            }
+
+            return bytes;
+        }
+
+        if (timeout != -1) {
+            auto now = Time::get_time_in_ms();
+
+            if (now >= deadline) {
+                return -1;
+            }
+
+            timeout = static_cast<ssize_t>(deadline - now);
+        }
+    }
+}
+
+auto TunInterface::wait_readable(ssize_t timeout) -> bool {
     fd_set input;
     FD_ZERO(&input);
     FD_SET(fd, &input);
@@ -76,51 +228,61 @@ auto TunInterface::receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssiz
     if (n == -1) {
         // this should never happen
         error("error on select");
-    } else if (n == 0) {
-        // timeout on select
-        return -1;
     }
 
-    auto bytes = read(fd, tun_buffer, len);
+    // n == 0 on timeout
+    return n > 0;
+}
+
+auto TunInterface::read_packet(uint8_t *buffer, size_t len) -> ssize_t {
+    auto bytes = read(fd, tun_buffer, buffer_len);
 
     if (bytes < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // no more packets queued
+            return -1;
+        }
+
         error("could not read from TUN interface");
     }
 
     if (bytes < 20) {
         warn("received less data than minimum IPv4 header size");
-        return -1;
+        return 0;
     }
 
     auto packet = Ipv4Packet::create_unchecked(tun_buffer, bytes);
 
     // valid IPv4 packet?
     if (!packet.is_valid_packet()) {
-        return -1;
+        return 0;
     }
 
     // S3TP packet?
     if (packet.protocol() != 0x99) {
-        return -1;
+        return 0;
     }
 
     // IPv4 packet from correct peer?
     if (packet.src_ip() != dst_addr) {
-        return -1;
+        return 0;
     }
 
     // IPv4 packet for wrong host?
     if (packet.dst_ip() != src_addr) {
-        return -1;
+        return 0;
     }
 
     // copy S3TP packet to buffer and return its size
     auto ip_header_size = packet.ihl() * 4;
 
-    for (auto i = ip_header_size; i < bytes; i++) {
-        buffer[i - ip_header_size] = tun_buffer[i];
+    if (static_cast<size_t>(bytes - ip_header_size) > len) {
+        warn("received S3TP packet exceeds buffer size");
+        return 0;
     }
 
+    memcpy(buffer, tun_buffer + ip_header_size, bytes - ip_header_size);
+
     return bytes - ip_header_size;
 }
 
@@ -156,4 +318,35 @@ auto TunInterface::send(const uint8_t *buffer, size_t len, ssize_t timeout) -> s
     return (sent == packet.length()) ? len : -1;
 }
 
+auto TunInterface::send_batch(const network_buffer *packets, size_t count, ssize_t timeout) -> size_t {
+    size_t sent = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        auto len = packets[i].len;
+
+        if (len < 42) {
+            warn("S3TP packet to be transmitted looks truncated");
+        }
+
+        // only the IPv4 header is written to the transmit buffer, the S3TP
+        // packet is passed to the kernel without copying it
+        auto header = Ipv4Packet::create_unchecked(tun_buffer, buffer_len);
+
+        header.initialize(identification++, src_addr, dst_addr);
+        header.set_length(static_cast<uint16_t>(header.ihl() * 4 + len));
+        header.update_checksum();
+
+        struct iovec iov[2]{
+                {tun_buffer, static_cast<size_t>(header.ihl() * 4)},
+                {const_cast<uint8_t *>(packets[i].data), len}
+        };
+
+        if (writev(fd, iov, 2) == header.length()) {
+            sent++;
+        }
+    }
+
+    return sent;
+}
+
 }  // namespace space_tcp
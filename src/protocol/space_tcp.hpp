@@ -3,9 +3,14 @@
 
 #include "crypto/aes128.hpp"
 #include "crypto/hmac.hpp"
+#include "space_tcp/compression.hpp"
+#include "space_tcp/fec.hpp"
 #include "space_tcp/log.hpp"
+#include "space_tcp/sequence.hpp"
 #include "protocol.hpp"
 
+#include <cstring>
+
 #ifndef __rodos__
 
 #include <arpa/inet.h>
@@ -21,6 +26,13 @@ enum class Flag {
     Ack = 0x2,
     Rst = 0x4,
     Fin = 0x8,
+    /// Header options follow the fixed header.
+    Opt = 0x10,
+    /// The payload is compressed, see LzCompressor.
+    Cmp = 0x20,
+    /// The sender understands header options, set in SYN and SYN+ACK packets.
+    /// Hosts which do not know header options ignore the flag.
+    OptOk = 0x40,
 };
 
 /// OR operator to combine S3TP flags, e.g., 0x3 = Flag::Syn | Flag::Ack.
@@ -33,8 +45,56 @@ inline auto operator&(Flag a, Flag b) -> Flag {
     return static_cast<Flag>(static_cast<uint8_t>(a) & static_cast<uint8_t>(b));
 }
 
+/// Message types of S3TP packets.
+enum class MsgType : uint8_t {
+    /// Standard message with 16-bit sequence numbers.
+    Standard = 0x1,
+    /// Message with 32-bit sequence numbers. The upper halves of the
+    /// sequence and acknowledgment numbers follow the HMAC.
+    Extended = 0x2,
+    /// Repair packet of forward error correction, its payload is the XOR of
+    /// data segments. Carries 32-bit sequence numbers like extended messages.
+    Repair = 0x3,
+    /// Symbol of a fountain-coded object, the sequence number is the id of
+    /// the symbol. Carries 32-bit sequence numbers like extended messages.
+    Fountain = 0x4,
+};
+
+/// Header options of S3TP packets. Options are encoded as type, length and
+/// value, the length excludes type and length byte.
+enum class Option : uint8_t {
+    /// Maximum segment size, i.e., largest payload the sender can receive.
+    Mss = 0x1,
+    /// Selective acknowledgment, i.e., ranges of sequence numbers received
+    /// beyond the acknowledgment number.
+    Sack = 0x2,
+    /// Receive window, i.e., data the sender can store beyond the
+    /// acknowledgment number.
+    Window = 0x3,
+    /// Position of a data segment in the forward error correction code.
+    Fec = 0x4,
+    /// Position of a repair packet in the forward error correction code and
+    /// the data segments it covers.
+    Repair = 0x5,
+    /// Size of a fountain-coded object.
+    Object = 0x6,
+    /// Payload compression the sender can decompress, only valid in SYN and
+    /// SYN+ACK packets.
+    Compression = 0x7,
+};
+
+/// Compression algorithms of the compression option.
+enum class Compression : uint8_t {
+    None = 0x0,
+    /// LZ77 compression of LzCompressor.
+    Lz = 0x1,
+};
+
 class SpaceTcpPacket : public Protocol {
 public:
+    /// Maximum size of the options block, including its length byte.
+    static constexpr size_t MAX_OPTIONS_SIZE = 64;
+
     /// Interpret buffer as a S3TP packet. Creation of a S3TP packet has no
     /// effect on the data in the underlying buffer.
     static auto create_unchecked(uint8_t *buffer, size_t len) -> SpaceTcpPacket {
@@ -66,14 +126,70 @@ public:
         return ntohs((buffer[5] << 8) + buffer[4]);
     }
 
+    /// Return whether the packet carries 32-bit sequence numbers. Repair and
+    /// fountain packets always do.
+    auto is_extended() -> bool {
+        return msg_type() == static_cast<uint8_t>(MsgType::Extended) ||
+               msg_type() == static_cast<uint8_t>(MsgType::Repair) ||
+               msg_type() == static_cast<uint8_t>(MsgType::Fountain);
+    }
+
+    /// Return whether the packet is a repair packet of forward error
+    /// correction.
+    auto is_repair() -> bool {
+        return msg_type() == static_cast<uint8_t>(MsgType::Repair);
+    }
+
+    /// Return whether the packet belongs to a fountain-coded transfer.
+    auto is_fountain() -> bool {
+        return msg_type() == static_cast<uint8_t>(MsgType::Fountain);
+    }
+
+    /// Return size of the fixed header (in bytes).
+    auto fixed_header_size() -> size_t {
+        return is_extended() ? 48 : 44;
+    }
+
+    /// Return size of the options block (in bytes). The block starts with
+    /// its length and is only present if the `Opt` flag is set.
+    auto options_size() -> size_t {
+        if ((flags() & Flag::Opt) != Flag::Opt) {
+            return 0;
+        }
+
+        return 1 + buffer[fixed_header_size()];
+    }
+
+    /// Return size of the header including options (in bytes).
+    auto header_size() -> size_t {
+        return fixed_header_size() + options_size();
+    }
+
+    /// Return size of the packet, i.e., header and payload (in bytes).
+    auto length() -> size_t {
+        return header_size() + size();
+    }
+
     /// Return sequence number.
-    auto seq_num() -> uint16_t {
-        return ntohs((buffer[7] << 8) + buffer[6]);
+    auto seq_num() -> uint32_t {
+        uint32_t seq_num = ntohs((buffer[7] << 8) + buffer[6]);
+
+        if (is_extended()) {
+            seq_num |= static_cast<uint32_t>(ntohs((buffer[45] << 8) + buffer[44])) << 16;
+        }
+
+        return seq_num;
     }
 
     /// Return acknowledgment number.
-    auto ack_num() -> uint16_t {
-        return ntohs((buffer[9] << 8) + buffer[8]);
+    auto ack_num() -> uint32_t {
+        uint32_t ack_num = ntohs((buffer[9] << 8) + buffer[8]);
+
+        if (is_extended()) {
+            ack_num |= static_cast<uint32_t>(ntohs((buffer[47] << 8) + buffer[46])) << 16;
+        }
+
+        return ack_num;
     }
 
     /// Return size of payload (in bytes).
@@ -88,7 +204,7 @@ public:
 
     /// Return pointer to payload.
     auto payload() -> uint8_t * {
-        return buffer + 44;
+        return buffer + header_size();
     }
 
     /// Set protocol version. Currently, only 0x1 is defined.
@@ -122,20 +238,302 @@ public:
         buffer[5] = static_cast<uint8_t>(dst_port >> 8);
     }
 
-    /// Set sequence number field.
-    auto set_seq_num(uint16_t seq_number) {
-        seq_number = htons(seq_number);
+    /// Set sequence number field. Standard messages carry the lower 16 bits
+    /// of the sequence number only.
+    auto set_seq_num(uint32_t seq_number) {
+        auto low = htons(static_cast<uint16_t>(seq_number));
+
+        buffer[6] = static_cast<uint8_t>(low);
+        buffer[7] = static_cast<uint8_t>(low >> 8);
+
+        if (is_extended()) {
+            auto high = htons(static_cast<uint16_t>(seq_number >> 16));
+
+            buffer[44] = static_cast<uint8_t>(high);
+            buffer[45] = static_cast<uint8_t>(high >> 8);
+        }
+    }
+
+    /// Set acknowledgment field. Standard messages carry the lower 16 bits
+    /// of the acknowledgment number only.
+    auto set_ack_num(uint32_t ack_number) {
+        auto low = htons(static_cast<uint16_t>(ack_number));
+
+        buffer[8] = static_cast<uint8_t>(low);
+        buffer[9] = static_cast<uint8_t>(low >> 8);
+
+        if (is_extended()) {
+            auto high = htons(static_cast<uint16_t>(ack_number >> 16));
+
+            buffer[46] = static_cast<uint8_t>(high);
+            buffer[47] = static_cast<uint8_t>(high >> 8);
+        }
+    }
+
+    /// Appends option `type` with a value of `len` bytes to the header. Add
+    /// options after setting the flags and before setting the payload.
+    /// Returns false if the options block is full.
+    auto add_option(Option type, const uint8_t *value, uint8_t len) -> bool {
+        auto block = buffer + fixed_header_size();
+
+        if ((flags() & Flag::Opt) != Flag::Opt) {
+            set_flags(flags() | Flag::Opt);
+            block[0] = 0;
+        }
+
+        auto used = static_cast<size_t>(1 + block[0]);
+
+        if (used + 2 + len > MAX_OPTIONS_SIZE || fixed_header_size() + used + 2 + len > this->len) {
+            warn("S3TP header options exceed maximum size");
+            return false;
+        }
+
+        auto option = block + used;
+
+        option[0] = static_cast<uint8_t>(type);
+        option[1] = len;
+
+        for (size_t i = 0; i < len; i++) {
+            option[2 + i] = value[i];
+        }
+
+        block[0] += 2 + len;
+
+        return true;
+    }
+
+    /// Returns a pointer to the value of option `type` and stores the length
+    /// of the value in `len`. Returns `nullptr` if the option is missing.
+    auto find_option(Option type, uint8_t &len) -> const uint8_t * {
+        if ((flags() & Flag::Opt) != Flag::Opt) {
+            return nullptr;
+        }
+
+        auto size = static_cast<size_t>(buffer[fixed_header_size()]);
+        auto options = buffer + fixed_header_size() + 1;
+
+        for (size_t i = 0; i + 2 <= size; i += 2 + options[i + 1]) {
+            if (i + 2 + options[i + 1] > size) {
+                break;
+            }
 
-        buffer[6] = static_cast<uint8_t>(seq_number);
-        buffer[7] = static_cast<uint8_t>(seq_number >> 8);
+            if (options[i] == static_cast<uint8_t>(type)) {
+                len = options[i + 1];
+                return options + i + 2;
+            }
+        }
+
+        return nullptr;
     }
 
-    /// Set acknowledgment field.
-    auto set_ack_num(uint16_t ack_number) {
-        ack_number = htons(ack_number);
+    /// Adds a maximum segment size option to the header.
+    auto set_mss_option(uint16_t mss) -> bool {
+        uint8_t value[2]{static_cast<uint8_t>(mss >> 8), static_cast<uint8_t>(mss)};
 
-        buffer[8] = static_cast<uint8_t>(ack_number);
-        buffer[9] = static_cast<uint8_t>(ack_number >> 8);
+        return add_option(Option::Mss, value, sizeof(value));
+    }
+
+    /// Returns the maximum segment size option or 0 if the option is missing.
+    auto mss_option() -> uint16_t {
+        uint8_t len{};
+        auto value = find_option(Option::Mss, len);
+
+        if (!value || len != 2) {
+            return 0;
+        }
+
+        return static_cast<uint16_t>((value[0] << 8) + value[1]);
+    }
+
+    /// Adds a receive window option (bytes) to the header.
+    auto set_window_option(uint32_t window) -> bool {
+        uint8_t value[] = {static_cast<uint8_t>(window >> 24), static_cast<uint8_t>(window >> 16),
+                           static_cast<uint8_t>(window >> 8), static_cast<uint8_t>(window)};
+
+        return add_option(Option::Window, value, sizeof(value));
+    }
+
+    /// Stores the receive window option in `window`. Returns false if the
+    /// option is missing.
+    auto window_option(uint32_t &window) -> bool {
+        uint8_t len{};
+        auto value = find_option(Option::Window, len);
+
+        if (!value || len != 4) {
+            return false;
+        }
+
+        window = (static_cast<uint32_t>(value[0]) << 24) | (static_cast<uint32_t>(value[1]) << 16) |
+                 (static_cast<uint32_t>(value[2]) << 8) | value[3];
+
+        return true;
+    }
+
+    /// Adds a selective acknowledgment option with `count` ranges to the
+    /// header. Range boundaries are encoded with 32 bits.
+    auto set_sack_option(const seq_range *ranges, size_t count) -> bool {
+        uint8_t value[8 * MAX_SACK_BLOCKS];
+
+        count = (count > MAX_SACK_BLOCKS) ? MAX_SACK_BLOCKS : count;
+
+        for (size_t i = 0; i < count; i++) {
+            auto bytes = value + 8 * i;
+
+            for (auto j = 0; j < 4; j++) {
+                bytes[j] = static_cast<uint8_t>(ranges[i].start >> (24 - 8 * j));
+                bytes[4 + j] = static_cast<uint8_t>(ranges[i].end >> (24 - 8 * j));
+            }
+        }
+
+        return add_option(Option::Sack, value, static_cast<uint8_t>(8 * count));
+    }
+
+    /// Stores up to `max` ranges of the selective acknowledgment option in
+    /// `ranges`. Returns the number of ranges, 0 if the option is missing.
+    auto sack_option(seq_range *ranges, size_t max) -> size_t {
+        uint8_t len{};
+        auto value = find_option(Option::Sack, len);
+
+        if (!value || len % 8 != 0) {
+            return 0;
+        }
+
+        size_t count = 0;
+
+        for (; count < max && count < len / 8u; count++) {
+            auto bytes = value + 8 * count;
+
+            ranges[count] = {};
+
+            for (auto j = 0; j < 4; j++) {
+                ranges[count].start = (ranges[count].start << 8) | bytes[j];
+                ranges[count].end = (ranges[count].end << 8) | bytes[4 + j];
+            }
+        }
+
+        return count;
+    }
+
+    /// Adds the position `tag` of a data segment in the forward error
+    /// correction code to the header.
+    auto set_fec_option(const fec_tag &tag) -> bool {
+        uint8_t value[] = {static_cast<uint8_t>(tag.group >> 8), static_cast<uint8_t>(tag.group), tag.index,
+                           tag.lanes};
+
+        return add_option(Option::Fec, value, sizeof(value));
+    }
+
+    /// Stores the position of a data segment in the forward error correction
+    /// code in `tag`. Returns false if the option is missing.
+    auto fec_option(fec_tag &tag) -> bool {
+        uint8_t len{};
+        auto value = find_option(Option::Fec, len);
+
+        if (!value || len != 4) {
+            return false;
+        }
+
+        tag = {static_cast<uint16_t>((value[0] << 8) + value[1]), value[2], value[3]};
+
+        return true;
+    }
+
+    /// Adds the position `tag` of a repair packet and the `count` data
+    /// segments it covers to the header. Segments are encoded with a 32-bit
+    /// sequence number and a 16-bit length.
+    auto set_repair_option(const fec_tag &tag, const seq_range *segments, size_t count) -> bool {
+        uint8_t value[4 + 6 * ForwardErrorCorrection::MAX_LANE_SEGMENTS] = {
+                static_cast<uint8_t>(tag.group >> 8), static_cast<uint8_t>(tag.group), tag.index, tag.lanes};
+
+        count = (count > ForwardErrorCorrection::MAX_LANE_SEGMENTS) ? ForwardErrorCorrection::MAX_LANE_SEGMENTS
+                                                                     : count;
+
+        for (size_t i = 0; i < count; i++) {
+            auto bytes = value + 4 + 6 * i;
+            auto len = segments[i].end - segments[i].start;
+
+            for (auto j = 0; j < 4; j++) {
+                bytes[j] = static_cast<uint8_t>(segments[i].start >> (24 - 8 * j));
+            }
+
+            bytes[4] = static_cast<uint8_t>(len >> 8);
+            bytes[5] = static_cast<uint8_t>(len);
+        }
+
+        return add_option(Option::Repair, value, static_cast<uint8_t>(4 + 6 * count));
+    }
+
+    /// Stores the position of a repair packet in `tag` and up to `max` data
+    /// segments it covers in `segments`. Returns the number of segments, 0 if
+    /// the option is missing.
+    auto repair_option(fec_tag &tag, seq_range *segments, size_t max) -> size_t {
+        uint8_t len{};
+        auto value = find_option(Option::Repair, len);
+
+        if (!value || len < 4 || (len - 4) % 6 != 0) {
+            return 0;
+        }
+
+        tag = {static_cast<uint16_t>((value[0] << 8) + value[1]), value[2], value[3]};
+
+        size_t count = 0;
+
+        for (; count < max && count < (len - 4u) / 6; count++) {
+            auto bytes = value + 4 + 6 * count;
+
+            uint32_t start = 0;
+
+            for (auto j = 0; j < 4; j++) {
+                start = (start << 8) | bytes[j];
+            }
+
+            segments[count] = {start, start + static_cast<uint32_t>((bytes[4] << 8) + bytes[5])};
+        }
+
+        return count;
+    }
+
+    /// Adds the size (bytes) of a fountain-coded object to the header.
+    auto set_object_option(uint32_t size) -> bool {
+        uint8_t value[] = {static_cast<uint8_t>(size >> 24), static_cast<uint8_t>(size >> 16),
+                           static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size)};
+
+        return add_option(Option::Object, value, sizeof(value));
+    }
+
+    /// Returns the size of a fountain-coded object or 0 if the option is
+    /// missing.
+    auto object_option() -> uint32_t {
+        uint8_t len{};
+        auto value = find_option(Option::Object, len);
+
+        if (!value || len != 4) {
+            return 0;
+        }
+
+        return (static_cast<uint32_t>(value[0]) << 24) | (static_cast<uint32_t>(value[1]) << 16) |
+               (static_cast<uint32_t>(value[2]) << 8) | value[3];
+    }
+
+    /// Announces that the sender can decompress payloads compressed with
+    /// `algorithm`.
+    auto set_compression_option(Compression algorithm) -> bool {
+        uint8_t value[] = {static_cast<uint8_t>(algorithm)};
+
+        return add_option(Option::Compression, value, sizeof(value));
+    }
+
+    /// Returns the compression algorithm announced in the header or
+    /// Compression::None if the option is missing.
+    auto compression_option() -> Compression {
+        uint8_t len{};
+        auto value = find_option(Option::Compression, len);
+
+        if (!value || len != 1) {
+            return Compression::None;
+        }
+
+        return static_cast<Compression>(value[0]);
     }
 
     /// Set size field (payload size in bytes).
@@ -157,9 +555,9 @@ public:
 
     /// Copy data to payload and set packet size to amount of copied data.
     auto set_payload(const uint8_t *payload, size_t len) {
-        if (44 + len > this->len) {
+        if (header_size() + len > this->len) {
             warn("payload exceeds buffer size and will be truncated");
-            len = this->len - 44;
+            len = this->len - header_size();
         }
 
         set_size(static_cast<uint16_t>(len));
@@ -176,9 +574,9 @@ public:
         size_t offset = size();
         size_t pad = static_cast<uint8_t>(16 - (offset % 16));
 
-        if (offset + pad + 44 > len) {
+        if (offset + pad + header_size() > len) {
             warn("padded payload exceeds buffer size, payload will be truncated");
-            offset = static_cast<uint16_t>(len - 44 - pad);
+            offset = static_cast<uint16_t>(len - header_size() - pad);
         }
 
         for (size_t i = 0; i < pad; i++) {
@@ -201,23 +599,60 @@ public:
         set_size(offset - pad);
     }
 
+    /// Decompresses the payload of a packet with the Cmp flag in place, the
+    /// buffer beyond the payload is used as scratch space. Returns false if
+    /// the payload is malformed.
+    auto decompress_payload() -> bool {
+        auto capacity = len - header_size();
+        auto compressed = size();
+
+        // the decompressor reads from the end of the buffer
+        memmove(payload() + capacity - compressed, payload(), compressed);
+
+        auto decompressed = lz_decompress(payload(), capacity, compressed);
+
+        if (decompressed < 0 || decompressed > 0xffff) {
+            return false;
+        }
+
+        set_flags(static_cast<Flag>(static_cast<uint8_t>(flags()) & ~static_cast<uint8_t>(Flag::Cmp)));
+        set_size(static_cast<uint16_t>(decompressed));
+
+        return true;
+    }
+
+    /// Stores the IV of this packet, derived from the IV `iv` of the
+    /// endpoint, in `message_iv`. The IV depends on the sequence number and,
+    /// for repair and fountain packets, on the message type: a repair packet
+    /// carries the sequence number of the first segment of its group, which
+    /// must not share the IV of that segment.
+    void message_iv(const uint8_t *iv, uint8_t *message_iv) {
+        auto seq = seq_num();
+
+        for (size_t i = 0; i < 16; i++) {
+            message_iv[i] = iv[i];
+        }
+
+        message_iv[0] ^= seq >> 8;
+        message_iv[1] ^= seq;
+        message_iv[2] ^= seq >> 24;
+        message_iv[3] ^= seq >> 16;
+
+        if (is_repair() || is_fountain()) {
+            message_iv[4] ^= msg_type();
+        }
+    }
+
     /// Encrypts the payload of a S3TP packet. Payload size must be a multiple
     /// of 16 bytes. Execute pad_payload() before encryption to achieve this
     /// property.
     auto encrypt_payload(const uint8_t *key, uint8_t *iv) {
         auto aes = space_tcp::Aes128::create();
-        auto seq = seq_num();
-
-        // message IV depends on sequence number
-        iv[0] ^= seq >> 8;
-        iv[1] ^= seq;
 
-        aes.init(key, iv);
-
-        // reset IV to previous value
-        iv[0] ^= seq >> 8;
-        iv[1] ^= seq;
+        uint8_t packet_iv[16];
+        message_iv(iv, packet_iv);
 
+        aes.init(key, packet_iv);
         aes.encrypt_cbc(payload(), size());
     }
 
@@ -226,18 +661,11 @@ public:
     /// execute depad_payload() to remove the PKCS#7 padding.
     auto decrypt_payload(const uint8_t *key, uint8_t *iv) {
         auto aes = space_tcp::Aes128::create();
-        auto seq = seq_num();
-
-        // message IV depends on sequence number
-        iv[0] ^= seq >> 8;
-        iv[1] ^= seq;
 
-        aes.init(key, iv);
-
-        // reset IV to previous value
-        iv[0] ^= seq >> 8;
-        iv[1] ^= seq;
+        uint8_t packet_iv[16];
+        message_iv(iv, packet_iv);
 
+        aes.init(key, packet_iv);
         aes.decrypt_cbc(payload(), size());
     }
 
@@ -248,12 +676,28 @@ public:
             return false;
         }
 
-        if (44 > this->len) {
+        if (msg_type() != static_cast<uint8_t>(MsgType::Standard) &&
+            msg_type() != static_cast<uint8_t>(MsgType::Extended) &&
+            msg_type() != static_cast<uint8_t>(MsgType::Repair) &&
+            msg_type() != static_cast<uint8_t>(MsgType::Fountain)) {
+            warn("S3TP packet with invalid message type");
+            return false;
+        }
+
+        if (fixed_header_size() > this->len) {
             warn("S3TP packet with truncated header");
             return false;
         }
 
-        if (static_cast<size_t>(44 + size()) > this->len) {
+        if ((flags() & Flag::Opt) == Flag::Opt) {
+            if (fixed_header_size() + 1 > this->len || options_size() > MAX_OPTIONS_SIZE ||
+                header_size() > this->len) {
+                warn("S3TP packet with invalid options");
+                return false;
+            }
+        }
+
+        if (length() > this->len) {
             warn("S3TP packet with truncated payload");
             return false;
         }
@@ -277,7 +721,7 @@ public:
         zero_hmac();
 
         auto hmac = space_tcp::Hmac::create(key, len);
-        hmac.sha256_finalize(this->buffer, 44 + size());
+        hmac.sha256_finalize(this->buffer, length());
 
         set_hmac(hmac.get_digest());
     }
@@ -293,7 +737,7 @@ public:
         zero_hmac();
 
         auto hmac = space_tcp::Hmac::create(key, len);
-        hmac.sha256_finalize(this->buffer, 44 + size());
+        hmac.sha256_finalize(this->buffer, length());
 
         set_hmac(hash);
 
@@ -306,10 +750,11 @@ public:
         return true;
     }
 
-    /// Initializes all header fields except HMAC.
-    auto initialize(uint16_t src_port, uint16_t dst_port, uint16_t seq_num) {
+    /// Initializes all header fields except HMAC. Extended packets carry
+    /// 32-bit sequence and acknowledgment numbers.
+    auto initialize(uint16_t src_port, uint16_t dst_port, uint32_t seq_num, bool extended = false) {
         set_version(0x1);
-        set_msg_type(0x1);
+        set_msg_type(static_cast<uint8_t>(extended ? MsgType::Extended : MsgType::Standard));
         set_flags(Flag::NoFlags); // no flags set by default
         set_src_port(src_port);
         set_dst_port(dst_port);
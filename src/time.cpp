@@ -8,4 +8,8 @@ auto space_tcp::Time::get_time_in_ms() -> uint64_t {
     return std::chrono::system_clock::now().time_since_epoch() / std::chrono::milliseconds(1);
 }
 
+auto space_tcp::Time::get_time_in_us() -> uint64_t {
+    return std::chrono::steady_clock::now().time_since_epoch() / std::chrono::microseconds(1);
+}
+
 }  // namespace space_tcp
\ No newline at end of file
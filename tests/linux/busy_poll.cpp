@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/network/busy_poll.hpp"
+
+TEST(BusyPollTest, Disabled) {
+    auto poller = space_tcp::BusyPoller::create(0);
+
+    EXPECT_FALSE(poller.enabled());
+    EXPECT_EQ(0, poller.budget());
+}
+
+TEST(BusyPollTest, FullBudgetWithoutSamples) {
+    auto poller = space_tcp::BusyPoller::create(800);
+
+    EXPECT_TRUE(poller.enabled());
+    EXPECT_EQ(800, poller.budget());
+}
+
+TEST(BusyPollTest, BudgetFollowsInterArrivalTime) {
+    auto poller = space_tcp::BusyPoller::create(800);
+
+    // packets every 160 us
+    for (uint64_t time = 1000; time < 100000; time += 160) {
+        poller.packet_arrived(time);
+    }
+
+    EXPECT_NEAR(320, poller.budget(), 40);
+
+    // packets every 10 ms, budget is capped
+    for (uint64_t time = 100000; time < 1000000; time += 10000) {
+        poller.packet_arrived(time);
+    }
+
+    EXPECT_EQ(800, poller.budget());
+
+    // back-to-back packets, budget does not drop below minimum
+    for (uint64_t time = 1000000; time < 1000100; time += 1) {
+        poller.packet_arrived(time);
+    }
+
+    EXPECT_EQ(50, poller.budget());
+}
+
+TEST(BusyPollTest, Statistics) {
+    auto poller = space_tcp::BusyPoller::create(800);
+
+    poller.spun(10, true);
+    poller.spun(800, false);
+    poller.slept();
+
+    auto stats = poller.statistics();
+
+    EXPECT_EQ(1, stats.spin_hits);
+    EXPECT_EQ(1, stats.spin_misses);
+    EXPECT_EQ(1, stats.sleeps);
+    EXPECT_EQ(810, stats.spin_time);
+}
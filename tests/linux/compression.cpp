@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/compression.hpp"
+
+#include <cstring>
+
+class CompressionTest : public ::testing::Test {
+public:
+    CompressionTest() {
+        const char text[] = "housekeeping telemetry frame: battery nominal, attitude nominal; ";
+
+        for (size_t i = 0; i < sizeof(input); i++) {
+            input[i] = static_cast<uint8_t>(text[i % (sizeof(text) - 1)]);
+        }
+    }
+
+protected:
+    // compresses `len` bytes of `data`, split after `split` bytes, and
+    // decompresses them again in place, returns 0 if either fails
+    auto round_trip(const uint8_t *data, size_t len, size_t split) -> size_t {
+        auto compressed = compressor.compress(data, split, data + split, len - split, output);
+
+        if (compressed == 0) {
+            return 0;
+        }
+
+        // as in a packet slot: the decompressed size plus the margin
+        auto capacity = len + space_tcp::LZ_IN_PLACE_MARGIN;
+        memmove(buffer + capacity - compressed, output, compressed);
+
+        auto decompressed = space_tcp::lz_decompress(buffer, capacity, compressed);
+
+        return (decompressed > 0) ? static_cast<size_t>(decompressed) : 0;
+    }
+
+    space_tcp::LzCompressor compressor = space_tcp::LzCompressor::create();
+
+    uint8_t input[1000]{};
+    uint8_t output[1000]{};
+    uint8_t buffer[1100]{};
+};
+
+TEST_F(CompressionTest, RoundTrip) {
+    auto compressed = compressor.compress(input, sizeof(input), nullptr, 0, output);
+
+    EXPECT_GT(compressed, 0);
+    EXPECT_LT(compressed, sizeof(input) / 4);
+
+    ASSERT_EQ(sizeof(input), round_trip(input, sizeof(input), sizeof(input)));
+    EXPECT_EQ(0, memcmp(input, buffer, sizeof(input)));
+}
+
+TEST_F(CompressionTest, SplitInput) {
+    // data wrapping around a ring buffer
+    for (size_t split : {0, 1, 3, 64, 500, 999}) {
+        memset(buffer, 0, sizeof(buffer));
+
+        ASSERT_EQ(sizeof(input), round_trip(input, sizeof(input), split));
+        EXPECT_EQ(0, memcmp(input, buffer, sizeof(input)));
+    }
+}
+
+TEST_F(CompressionTest, LongRuns) {
+    // match and literal lengths beyond 15 + 255
+    memset(input, 'a', 600);
+
+    for (size_t i = 600; i < sizeof(input); i++) {
+        input[i] = static_cast<uint8_t>(i * 131 + (i >> 3));
+    }
+
+    ASSERT_EQ(sizeof(input), round_trip(input, sizeof(input), sizeof(input)));
+    EXPECT_EQ(0, memcmp(input, buffer, sizeof(input)));
+}
+
+TEST_F(CompressionTest, MatchLengths) {
+    uint64_t state = 7;
+
+    // runs of `match` repeated bytes between random bytes, i.e., every
+    // length encoding in the token and beyond
+    for (size_t match = 4; match < 40; match++) {
+        for (size_t i = 0; i < sizeof(input); i++) {
+            state = state * 6364136223846793005u + 1442695040888963407u;
+            input[i] = (i % 64 < match) ? 'm' : static_cast<uint8_t>(state >> 56);
+        }
+
+        auto compressed = compressor.compress(input, sizeof(input), nullptr, 0, output);
+
+        if (compressed == 0) {
+            continue;
+        }
+
+        memcpy(buffer + sizeof(buffer) - compressed, output, compressed);
+
+        ASSERT_EQ(static_cast<ssize_t>(sizeof(input)), space_tcp::lz_decompress(buffer, sizeof(buffer), compressed));
+        EXPECT_EQ(0, memcmp(input, buffer, sizeof(input)));
+    }
+}
+
+TEST_F(CompressionTest, IncompressibleData) {
+    uint64_t state = 42;
+
+    for (auto &byte : input) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        byte = static_cast<uint8_t>(state >> 56);
+    }
+
+    EXPECT_EQ(0, compressor.compress(input, sizeof(input), nullptr, 0, output));
+}
+
+TEST_F(CompressionTest, ShortInput) {
+    EXPECT_EQ(0, compressor.compress(input, space_tcp::LzCompressor::MIN_INPUT - 1, nullptr, 0, output));
+}
+
+TEST_F(CompressionTest, MalformedInput) {
+    // match before the start of the output
+    uint8_t bad_offset[] = {0x10, 'a', 0x05, 0x00};
+    memcpy(buffer + sizeof(buffer) - sizeof(bad_offset), bad_offset, sizeof(bad_offset));
+    EXPECT_EQ(-1, space_tcp::lz_decompress(buffer, sizeof(buffer), sizeof(bad_offset)));
+
+    // literals beyond the end of the input
+    uint8_t truncated[] = {0x50, 'a', 'b'};
+    memcpy(buffer + sizeof(buffer) - sizeof(truncated), truncated, sizeof(truncated));
+    EXPECT_EQ(-1, space_tcp::lz_decompress(buffer, sizeof(buffer), sizeof(truncated)));
+
+    // output overtaking the input
+    uint8_t expanding[] = {0x1f, 'a', 0x01, 0x00, 0xff, 0xff, 0x00};
+    memcpy(buffer + 64 - sizeof(expanding), expanding, sizeof(expanding));
+    EXPECT_EQ(-1, space_tcp::lz_decompress(buffer, 64, sizeof(expanding)));
+}
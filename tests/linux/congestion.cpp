@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/congestion.hpp"
+
+TEST(AimdControllerTest, SlowStart) {
+    auto controller = space_tcp::AimdController::create();
+    controller.reset(500);
+
+    EXPECT_EQ(2000, controller.window());
+
+    // one segment per ACK
+    controller.acknowledged(1000, 2000, 0);
+    EXPECT_EQ(2500, controller.window());
+
+    controller.acknowledged(200, 2000, 0);
+    EXPECT_EQ(2700, controller.window());
+}
+
+TEST(AimdControllerTest, CongestionAvoidance) {
+    auto controller = space_tcp::AimdController::create();
+    controller.reset(500);
+
+    // loss halves the data in flight
+    controller.lost(4000);
+    EXPECT_EQ(2000, controller.window());
+
+    // one segment per window
+    for (auto i = 0; i < 3; i++) {
+        controller.acknowledged(500, 2000, 0);
+        EXPECT_EQ(2000, controller.window());
+    }
+
+    controller.acknowledged(500, 2000, 0);
+    EXPECT_EQ(2500, controller.window());
+}
+
+TEST(AimdControllerTest, Timeout) {
+    auto controller = space_tcp::AimdController::create();
+    controller.reset(500);
+
+    controller.timed_out(6000);
+    EXPECT_EQ(500, controller.window());
+
+    // slow start up to half the data in flight
+    for (auto i = 0; i < 5; i++) {
+        controller.acknowledged(500, 500, 0);
+    }
+
+    EXPECT_EQ(3000, controller.window());
+
+    controller.acknowledged(500, 3000, 0);
+    EXPECT_EQ(3000, controller.window());
+}
+
+TEST(DelayControllerTest, GrowsWithoutQueueing) {
+    auto controller = space_tcp::DelayController::create();
+    controller.reset(500);
+
+    EXPECT_EQ(2000, controller.window());
+
+    // ACKs without sample do not change the window
+    controller.acknowledged(500, 2000, 0);
+    EXPECT_EQ(2000, controller.window());
+
+    for (auto i = 0; i < 4; i++) {
+        controller.acknowledged(500, 2000, 100);
+    }
+
+    EXPECT_EQ(100, controller.min_rtt());
+    EXPECT_EQ(4000, controller.window());
+}
+
+TEST(DelayControllerTest, ShrinksWithQueueing) {
+    auto controller = space_tcp::DelayController::create();
+    controller.reset(500);
+
+    for (auto i = 0; i < 8; i++) {
+        controller.acknowledged(500, 2000, 100);
+    }
+
+    EXPECT_EQ(6000, controller.window());
+
+    // 6000 B * (200 ms - 100 ms) / 200 ms = 3000 B queued
+    controller.acknowledged(500, 6000, 200);
+    EXPECT_EQ(5500, controller.window());
+
+    // 5500 B * 50 ms / 150 ms = 1833 B queued, within bounds
+    controller.acknowledged(500, 5500, 150);
+    EXPECT_EQ(5500, controller.window());
+
+    controller.lost(5500);
+    EXPECT_EQ(4125, controller.window());
+
+    controller.timed_out(4125);
+    EXPECT_EQ(1000, controller.window());
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <space_tcp/space_tcp.hpp>
+
+class NoNetwork : public space_tcp::NetworkInterface {
+public:
+    auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        return -1;
+    }
+
+    auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        return len;
+    }
+};
+
+template<typename std::size_t S>
+class ConnectionStorage {
+public:
+    ConnectionStorage() : endpoint{space_tcp::TcpEndpoint::create(endpoint_buffer, sizeof(endpoint_buffer), connections,
+                                                                  network)} {}
+
+    auto create(uint8_t rx_port, uint8_t tx_port) -> space_tcp::Connection * {
+        auto buffer = connection_buffers + connections.stored_connections() * CONNECTION_BUFFER_SIZE;
+        return connections.create_connection(buffer, CONNECTION_BUFFER_SIZE, rx_port, tx_port, endpoint);
+    }
+
+    space_tcp::Connections<S> connections;
+
+private:
+    static constexpr size_t CONNECTION_BUFFER_SIZE = 1 << 11;
+
+    uint8_t endpoint_buffer[1 << 10]{};
+    uint8_t connection_buffers[S * CONNECTION_BUFFER_SIZE]{};
+    NoNetwork network;
+    space_tcp::TcpEndpoint endpoint;
+};
+
+TEST(ConnectionManagerTest, LinearLookup) {
+    auto storage = std::make_unique<ConnectionStorage<4>>();
+
+    auto a = storage->create(1, 2);
+    auto b = storage->create(2, 1);
+    auto c = storage->create(1, 3);
+
+    EXPECT_EQ(a, storage->connections.find_connection(1, 2));
+    EXPECT_EQ(b, storage->connections.find_connection(2, 1));
+    EXPECT_EQ(c, storage->connections.find_connection(1, 3));
+    EXPECT_EQ(nullptr, storage->connections.find_connection(3, 1));
+    EXPECT_EQ(nullptr, storage->connections.find_connection(0, 0));
+
+    EXPECT_TRUE(storage->connections.contains(c));
+    EXPECT_FALSE(storage->connections.contains(c + 1));
+}
+
+TEST(ConnectionManagerTest, HashedLookup) {
+    auto storage = std::make_unique<ConnectionStorage<200>>();
+
+    space_tcp::Connection *created[200];
+
+    for (size_t i = 0; i < 200; i++) {
+        created[i] = storage->create(static_cast<uint8_t>(i), 7);
+    }
+
+    EXPECT_EQ(200, storage->connections.stored_connections());
+
+    for (size_t i = 0; i < 200; i++) {
+        EXPECT_EQ(created[i], storage->connections.find_connection(i, 7));
+        EXPECT_EQ(nullptr, storage->connections.find_connection(i, 8));
+    }
+}
+
+class SlabConnectionsTest : public ::testing::Test {
+public:
+    SlabConnectionsTest() : endpoint{space_tcp::create_tcp_endpoint(endpoint_buffer, network, connections)} {}
+
+protected:
+    static constexpr size_t CONNECTION_BUFFER_SIZE = 1 << 11;
+
+    uint8_t endpoint_buffer[1 << 10]{};
+    uint8_t connection_buffer[CONNECTION_BUFFER_SIZE]{};
+    NoNetwork network;
+    space_tcp::SlabConnections connections;
+    space_tcp::TcpEndpoint endpoint;
+};
+
+TEST_F(SlabConnectionsTest, CreateAndFind) {
+    space_tcp::Connection *created[100];
+
+    for (size_t i = 0; i < 100; i++) {
+        created[i] = space_tcp::create_connection(connection_buffer, static_cast<uint8_t>(i), 7, endpoint);
+    }
+
+    EXPECT_EQ(100, connections.stored_connections());
+
+    for (size_t i = 0; i < 100; i++) {
+        EXPECT_EQ(created[i], connections.find_connection(i, 7));
+    }
+
+    EXPECT_EQ(nullptr, connections.find_connection(7, 8));
+}
+
+TEST_F(SlabConnectionsTest, DestroyAndReuse) {
+    space_tcp::Connection *created[40];
+
+    for (size_t i = 0; i < 40; i++) {
+        created[i] = space_tcp::create_connection(connection_buffer, static_cast<uint8_t>(i), 7, endpoint);
+    }
+
+    // destroy every second connection
+    for (size_t i = 0; i < 40; i += 2) {
+        EXPECT_TRUE(space_tcp::destroy_connection(created[i], endpoint));
+
+        // destroying again is detected without accessing the connection
+        EXPECT_FALSE(connections.contains(created[i]));
+        EXPECT_FALSE(space_tcp::destroy_connection(created[i], endpoint));
+    }
+
+    EXPECT_EQ(20, connections.stored_connections());
+
+    // remaining connections are still found at the same address
+    for (size_t i = 0; i < 40; i++) {
+        auto expected = (i % 2) ? created[i] : nullptr;
+        EXPECT_EQ(expected, connections.find_connection(i, 7));
+    }
+
+    // freed slots are reused
+    auto connection = space_tcp::create_connection(connection_buffer, 0, 7, endpoint);
+    EXPECT_EQ(created[38], connection);
+    EXPECT_EQ(connection, connections.find_connection(0, 7));
+
+    for (size_t i = 0; i < connections.stored_connections(); i++) {
+        EXPECT_NE(nullptr, connections.get_connection(i));
+    }
+}
+
+TEST_F(SlabConnectionsTest, DestroyActiveConnection) {
+    uint8_t data[] = "hallo";
+
+    auto connection = space_tcp::create_connection(connection_buffer, 1, 2, endpoint);
+
+    connection->send(data);
+    endpoint.tx();
+
+    EXPECT_EQ(space_tcp::State::SynSent, connection->get_state());
+    EXPECT_FALSE(space_tcp::destroy_connection(connection, endpoint));
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/coroutine.hpp"
+#include "space_tcp/space_tcp.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+// allocations of the test process, to tell whether awaiting allocates
+static size_t allocations = 0;
+
+auto operator new(size_t size) -> void * {
+    allocations++;
+
+    if (auto memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+// Packets in flight from one end of a link to the other, in fixed slots such
+// that the link does not allocate memory.
+struct Queue {
+    static constexpr size_t SLOTS = 64;
+
+    uint8_t packets[SLOTS][1 << 11]{};
+    size_t lens[SLOTS]{};
+    size_t head{};
+    size_t tail{};
+};
+
+// One end of a lossless link, both ends are driven by the same thread.
+class LinkEnd : public space_tcp::NetworkInterface {
+public:
+    LinkEnd(Queue &in, Queue &out) : in{in}, out{out} {}
+
+    auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        if (in.head == in.tail) {
+            return -1;
+        }
+
+        auto i = in.tail++ % Queue::SLOTS;
+        len = (len > in.lens[i]) ? in.lens[i] : len;
+        memcpy(buffer, in.packets[i], len);
+
+        return len;
+    }
+
+    auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        if (out.head - out.tail == Queue::SLOTS || len > sizeof(out.packets[0])) {
+            return -1;
+        }
+
+        auto i = out.head++ % Queue::SLOTS;
+        memcpy(out.packets[i], buffer, len);
+        out.lens[i] = len;
+
+        return len;
+    }
+
+private:
+    Queue &in;
+    Queue &out;
+};
+
+class CoroutineTest : public ::testing::Test {
+protected:
+    static constexpr size_t SESSIONS = 16;
+
+    CoroutineTest() {
+        for (uint8_t i = 0; i < SESSIONS; i++) {
+            client[i] = space_tcp::create_connection(client_buffer[i], 10 + i, 100 + i, endpoint_a);
+            server[i] = space_tcp::create_connection(server_buffer[i], 100 + i, 10 + i, endpoint_b);
+        }
+    }
+
+    // drives both endpoints until all coroutines returned
+    void run() {
+        for (size_t round = 0; round < 10000 && (executor_a.pending() || executor_b.pending()); round++) {
+            executor_a.poll();
+            executor_b.poll();
+        }
+    }
+
+    Queue a_to_b;
+    Queue b_to_a;
+    LinkEnd network_a{b_to_a, a_to_b};
+    LinkEnd network_b{a_to_b, b_to_a};
+
+    uint8_t space_tcp_buffer_a[1 << 12]{};
+    uint8_t space_tcp_buffer_b[1 << 12]{};
+    space_tcp::Connections<SESSIONS> connections_a;
+    space_tcp::Connections<SESSIONS> connections_b;
+    space_tcp::TcpEndpoint endpoint_a = space_tcp::create_tcp_endpoint(space_tcp_buffer_a, network_a, connections_a);
+    space_tcp::TcpEndpoint endpoint_b = space_tcp::create_tcp_endpoint(space_tcp_buffer_b, network_b, connections_b);
+    space_tcp::CoroutineExecutor executor_a = space_tcp::CoroutineExecutor::create(endpoint_a);
+    space_tcp::CoroutineExecutor executor_b = space_tcp::CoroutineExecutor::create(endpoint_b);
+
+    uint8_t client_buffer[SESSIONS][1 << 11]{};
+    uint8_t server_buffer[SESSIONS][1 << 11]{};
+    space_tcp::Connection *client[SESSIONS]{};
+    space_tcp::Connection *server[SESSIONS]{};
+};
+
+// sends `len` bytes of a pattern starting at `seed` and waits for as many
+// bytes echoed
+auto request(space_tcp::CoroutineExecutor &executor, space_tcp::Connection &connection, size_t len,
+             uint8_t seed, bool &done) -> space_tcp::Task {
+    uint8_t data[3000];
+    uint8_t echo[3000];
+
+    for (size_t i = 0; i < len; i++) {
+        data[i] = static_cast<uint8_t>(seed + i);
+    }
+
+    EXPECT_TRUE(co_await executor.connect(connection));
+    EXPECT_EQ(static_cast<ssize_t>(len), co_await executor.send(connection, data, len));
+
+    size_t received = 0;
+
+    while (received < len) {
+        auto chunk = co_await executor.receive(connection, echo + received, len - received);
+
+        if (chunk <= 0) {
+            break;
+        }
+
+        received += chunk;
+    }
+
+    EXPECT_EQ(len, received);
+    EXPECT_EQ(0, memcmp(data, echo, len));
+
+    co_await executor.close(connection);
+
+    done = true;
+}
+
+// echoes received data until the remote host closes the connection
+auto echo(space_tcp::CoroutineExecutor &executor, space_tcp::Connection &connection,
+          size_t &echoed) -> space_tcp::Task {
+    uint8_t buffer[256];
+
+    connection.listen();
+
+    while (true) {
+        auto len = co_await executor.receive(connection, buffer);
+
+        if (len <= 0) {
+            break;
+        }
+
+        EXPECT_EQ(len, co_await executor.send(connection, buffer, len));
+        echoed += len;
+    }
+}
+
+TEST_F(CoroutineTest, Echo) {
+    bool done = false;
+    size_t echoed = 0;
+
+    echo(executor_b, *server[0], echoed);
+    request(executor_a, *client[0], 3000, 7, done);
+
+    // both coroutines wait for the network
+    EXPECT_EQ(1, executor_a.pending());
+    EXPECT_EQ(1, executor_b.pending());
+
+    run();
+
+    EXPECT_TRUE(done);
+    EXPECT_EQ(3000, echoed);
+    EXPECT_EQ(0, executor_a.pending());
+    EXPECT_EQ(0, executor_b.pending());
+}
+
+TEST_F(CoroutineTest, ConcurrentSessions) {
+    bool done[SESSIONS]{};
+    size_t echoed[SESSIONS]{};
+
+    for (size_t i = 0; i < SESSIONS; i++) {
+        echo(executor_b, *server[i], echoed[i]);
+        request(executor_a, *client[i], 500 + 100 * i, static_cast<uint8_t>(i), done[i]);
+    }
+
+    // frames are allocated when the sessions start, resuming them is free
+    auto before = allocations;
+
+    for (size_t round = 0; round < 10000 && executor_a.pending() > 0; round++) {
+        executor_a.poll();
+        executor_b.poll();
+    }
+
+    EXPECT_EQ(before, allocations);
+
+    for (size_t i = 0; i < SESSIONS; i++) {
+        EXPECT_TRUE(done[i]);
+        EXPECT_EQ(500 + 100 * i, echoed[i]);
+    }
+}
+
+TEST_F(CoroutineTest, ReceiveAfterClose) {
+    bool finished = false;
+    ssize_t len = -1;
+
+    server[0]->listen();
+
+    [](space_tcp::CoroutineExecutor &executor, space_tcp::Connection &connection, ssize_t &len,
+       bool &finished) -> space_tcp::Task {
+        uint8_t buffer[16];
+
+        len = co_await executor.receive(connection, buffer);
+        finished = true;
+    }(executor_b, *server[0], len, finished);
+
+    [](space_tcp::CoroutineExecutor &executor, space_tcp::Connection &connection) -> space_tcp::Task {
+        co_await executor.connect(connection);
+        co_await executor.close(connection);
+    }(executor_a, *client[0]);
+
+    run();
+
+    // the remote host closed without sending data
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(0, len);
+}
+
+#endif
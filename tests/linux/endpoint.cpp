@@ -3,58 +3,102 @@
 #include <space_tcp/space_tcp.hpp>
 #include "space_tcp/endpoint.hpp"
 
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Loopback network which queues sent packets until they are received.
 class TestNetwork : public space_tcp::NetworkInterface {
 public:
-    auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
-        len = (len > data) ? data : len;
+    // a network with an MTU of 0 leaves the payload size to the endpoints
+    explicit TestNetwork(size_t mtu = 0) : packet_size{mtu ? mtu : 1 << 10}, reported_mtu{mtu},
+                                           data(QUEUE_SIZE * packet_size) {}
+
+    auto mtu() -> size_t override {
+        return reported_mtu;
+    }
 
-        if (len == 0) {
+    auto rate() -> uint64_t override {
+        return link_rate;
+    }
+
+    auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        if (head == tail) {
             return -1;
         }
 
-        for (size_t i = 0; i < len; i++) {
-            buffer[i] = this->buffer[i];
-        }
+        auto i = tail++ % QUEUE_SIZE;
+
+        len = (len > lens[i]) ? lens[i] : len;
+
+        memcpy(buffer, &data[i * packet_size], len);
 
         return len;
     }
 
     auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
-        for (size_t i = 0; i < len; i++) {
-            this->buffer[i] = buffer[i];
+        if (head - tail == QUEUE_SIZE) {
+            return -1;
         }
 
-        data = len;
+        auto i = head++ % QUEUE_SIZE;
+
+        len = (len > packet_size) ? packet_size : len;
 
-        return data;
+        memcpy(&data[i * packet_size], buffer, len);
+        lens[i] = len;
+
+        sent++;
+        sent_bytes += len;
+
+        return len;
     }
 
-private:
-    uint8_t buffer[1 << 12]{};
-    size_t data{};
-};
+    // number of packets queued in the network
+    [[nodiscard]] auto queued() const -> size_t {
+        return head - tail;
+    }
 
-class TcpEndpointTest : public ::testing::Test {
-public:
-    TcpEndpointTest() {
-        auto endpoint_obj_a = space_tcp::TcpEndpoint::create(space_tcp_buffer_a, sizeof(space_tcp_buffer_a), connections_a,
-                                                           network);
+    // flags of the `n`-th packet queued in the network
+    [[nodiscard]] auto flags(size_t n) const -> uint8_t {
+        return data[(tail + n) % QUEUE_SIZE * packet_size + 1];
+    }
+
+    // drops the `n`-th packet queued in the network
+    void drop(size_t n) {
+        for (auto i = tail + n; i + 1 < head; i++) {
+            memcpy(&data[i % QUEUE_SIZE * packet_size], &data[(i + 1) % QUEUE_SIZE * packet_size], packet_size);
+            lens[i % QUEUE_SIZE] = lens[(i + 1) % QUEUE_SIZE];
+        }
 
-        auto endpoint_mem_a = malloc(sizeof(space_tcp::TcpEndpoint));
-        memcpy(endpoint_mem_a, &endpoint_obj_a, sizeof(space_tcp::TcpEndpoint));
+        head--;
+    }
 
-        endpoint_a = static_cast<space_tcp::TcpEndpoint *>(endpoint_mem_a);
+    // number of packets and bytes sent via this network
+    size_t sent{};
+    size_t sent_bytes{};
 
-        connection_a = space_tcp::create_connection(connection_buffer_a, 13, 17, *endpoint_a);
+    // rate reported to endpoints created afterwards (bytes per second)
+    uint64_t link_rate{};
+
+private:
+    static constexpr size_t QUEUE_SIZE = 64;
 
-        auto endpoint_obj_b = space_tcp::TcpEndpoint::create(space_tcp_buffer_b, sizeof(space_tcp_buffer_b), connections_b,
-                                                           network);
+    size_t packet_size;
+    size_t reported_mtu;
 
-        auto endpoint_mem_b = malloc(sizeof(space_tcp::TcpEndpoint));
-        memcpy(endpoint_mem_b, &endpoint_obj_b, sizeof(space_tcp::TcpEndpoint));
+    std::vector<uint8_t> data;
+    size_t lens[QUEUE_SIZE]{};
 
-        endpoint_b = static_cast<space_tcp::TcpEndpoint *>(endpoint_mem_b);
+    size_t head{};
+    size_t tail{};
+};
 
+class TcpEndpointTest : public ::testing::Test {
+public:
+    TcpEndpointTest() {
+        connection_a = space_tcp::create_connection(connection_buffer_a, 13, 17, *endpoint_a);
         connection_b = space_tcp::create_connection(connection_buffer_b, 17, 13, *endpoint_b);
     };
 
@@ -63,13 +107,20 @@ protected:
     uint8_t connection_buffer_a[1 << 12]{};
     space_tcp::Connections<1> connections_a;
     TestNetwork network{};
-    space_tcp::TcpEndpoint *endpoint_a;
+
+    // the endpoints are constructed in place, they must not be copied once
+    // connections refer to them
+    space_tcp::TcpEndpoint endpoint_obj_a{
+            space_tcp::TcpEndpoint::create(space_tcp_buffer_a, sizeof(space_tcp_buffer_a), connections_a, network)};
+    space_tcp::TcpEndpoint *endpoint_a{&endpoint_obj_a};
     space_tcp::Connection *connection_a;
 
     uint8_t space_tcp_buffer_b[1 << 12]{};
     uint8_t connection_buffer_b[1 << 12]{};
     space_tcp::Connections<1> connections_b;
-    space_tcp::TcpEndpoint *endpoint_b;
+    space_tcp::TcpEndpoint endpoint_obj_b{
+            space_tcp::TcpEndpoint::create(space_tcp_buffer_b, sizeof(space_tcp_buffer_b), connections_b, network)};
+    space_tcp::TcpEndpoint *endpoint_b{&endpoint_obj_b};
     space_tcp::Connection *connection_b;
 };
 
@@ -92,4 +143,1161 @@ TEST_F(TcpEndpointTest, ConnectionTest) {
 
     endpoint_b->rx();
     EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
-}
\ No newline at end of file
+
+    // both hosts know header options
+    EXPECT_TRUE(connection_a->header_options());
+    EXPECT_TRUE(connection_b->header_options());
+}
+
+TEST_F(TcpEndpointTest, ConnectWithoutDataTest) {
+    connection_b->listen();
+
+    // nothing to send, nothing happens
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    connection_a->connect();
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(space_tcp::State::SynSent, connection_a->get_state());
+
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_EQ(space_tcp::State::Established, connection_a->get_state());
+    EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
+
+    // the handshake carried no data
+    uint8_t received[16];
+    EXPECT_EQ(0, connection_b->receive(received));
+}
+
+TEST_F(TcpEndpointTest, IdleConnectionTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // nothing left to transmit
+    auto sent = network.sent;
+    endpoint_a->tx();
+    endpoint_b->tx();
+    EXPECT_EQ(sent, network.sent);
+
+    // new data makes the connection ready again
+    connection_a->send(data);
+    endpoint_a->tx();
+    EXPECT_EQ(sent + 1, network.sent);
+
+    // a single segment is acknowledged once the ACK delay passed
+    endpoint_b->rx();
+    EXPECT_EQ(sent + 1, network.sent);
+    EXPECT_LE(endpoint_b->next_deadline(), space_tcp::Time::get_time_in_ms() + space_tcp::DefaultConfig::ACK_DELAY);
+
+    usleep((space_tcp::DefaultConfig::ACK_DELAY + 2) * 1000);
+    endpoint_b->tx();
+    EXPECT_EQ(sent + 2, network.sent);
+
+    uint8_t received[2 * sizeof(data)]{};
+    EXPECT_EQ(sizeof(received), connection_b->receive(received));
+    EXPECT_EQ(0, memcmp(received + sizeof(data), data, sizeof(data)));
+}
+
+TEST_F(TcpEndpointTest, DelayedAckTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // four segments: 3 * 512 B + 464 B
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk);
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+
+    network.drop(2);
+
+    // every second segment received in order is acknowledged
+    auto sent = network.sent;
+    endpoint_b->rx(0);
+    EXPECT_EQ(sent, network.sent);
+    endpoint_b->rx(0);
+    EXPECT_EQ(sent + 1, network.sent);
+
+    // segment after a gap is acknowledged right away
+    endpoint_b->rx(0);
+    EXPECT_EQ(sent + 2, network.sent);
+}
+
+TEST_F(TcpEndpointTest, PiggybackAckTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data), connection_b->receive(received));
+
+    // single segment, its ACK is delayed
+    uint8_t telecommand[100]{};
+    connection_a->send(telecommand);
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    endpoint_b->rx(0);
+
+    // the answer carries the ACK
+    uint8_t telemetry[200]{};
+    connection_b->send(telemetry);
+
+    auto sent = network.sent;
+    EXPECT_EQ(1, endpoint_b->tx_burst(8));
+    EXPECT_EQ(sent + 1, network.sent);
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+    EXPECT_EQ(sizeof(telemetry), connection_a->receive(received));
+
+    // no separate ACK once the delay passed
+    usleep((space_tcp::DefaultConfig::ACK_DELAY + 2) * 1000);
+    EXPECT_EQ(0, endpoint_b->tx_burst(8));
+
+    EXPECT_EQ(sizeof(telecommand), connection_b->receive(received));
+}
+
+TEST_F(TcpEndpointTest, BurstTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // four segments: 3 * 512 B + 464 B
+    uint8_t bulk[2000]{};
+    EXPECT_EQ(sizeof(bulk), connection_a->send(bulk));
+
+    auto sent = network.sent;
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    EXPECT_EQ(sent + 4, network.sent);
+
+    // whole window in flight, nothing left to send
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+}
+
+TEST_F(TcpEndpointTest, RxBurstTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk);
+
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    EXPECT_EQ(4, network.queued());
+
+    // one ACK for the whole burst
+    auto sent = network.sent;
+    EXPECT_EQ(4, endpoint_b->rx_burst(8, 0));
+    EXPECT_EQ(sent + 1, network.sent);
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + sizeof(bulk), connection_b->receive(received));
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, SelectiveAcknowledgmentTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t bulk[2000];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = static_cast<uint8_t>(i);
+    }
+
+    connection_a->send(bulk);
+
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+
+    // second segment gets lost
+    network.drop(1);
+
+    // segments after the gap are stored, the ACK reports them
+    auto sent = network.sent;
+    EXPECT_EQ(3, endpoint_b->rx_burst(8, 0));
+    EXPECT_EQ(sent + 1, network.sent);
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + 512, connection_b->receive(received));
+
+    endpoint_a->rx(0);
+    EXPECT_FALSE(connection_a->tx_queue_empty());
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    usleep((connection_a->retransmission_timeout() + 10) * 1000);
+
+    // only the lost segment is retransmitted
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(1, endpoint_b->rx_burst(8, 0));
+
+    uint8_t reassembled[1 << 12]{};
+    EXPECT_EQ(sizeof(bulk) - 512, connection_b->receive(reassembled));
+    EXPECT_EQ(0, memcmp(received + sizeof(data), bulk, 512));
+    EXPECT_EQ(0, memcmp(reassembled, bulk + 512, sizeof(bulk) - 512));
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, FastRetransmitTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // four segments: 3 * 512 B + 100 B
+    uint8_t bulk[1636];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = static_cast<uint8_t>(i);
+    }
+
+    EXPECT_EQ(sizeof(bulk), connection_a->send(bulk));
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+
+    // first segment gets lost, every other segment is acknowledged on its own
+    network.drop(0);
+
+    for (auto i = 0; i < 3; i++) {
+        endpoint_b->rx(0);
+    }
+
+    // three duplicate ACKs
+    EXPECT_EQ(3, network.queued());
+
+    endpoint_a->rx(0);
+    endpoint_a->rx(0);
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    // third duplicate ACK retransmits the lost segment right away
+    endpoint_a->rx(0);
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    EXPECT_EQ(1, endpoint_b->rx_burst(8, 0));
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + sizeof(bulk), connection_b->receive(received));
+    EXPECT_EQ(0, memcmp(received + sizeof(data), bulk, sizeof(bulk)));
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, AdaptiveRetransmissionTimeoutTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    EXPECT_EQ(0, connection_a->rtt());
+    EXPECT_EQ(space_tcp::DefaultConfig::RETRANSMISSION_TIMEOUT, connection_a->retransmission_timeout());
+
+    // SYN takes 20 ms to the remote host
+    endpoint_a->tx();
+    usleep(20 * 1000);
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    auto rto = connection_a->retransmission_timeout();
+    EXPECT_GE(connection_a->rtt(), 20);
+    EXPECT_EQ(connection_a->rtt() / 2, connection_a->rtt_variation());
+    EXPECT_EQ(connection_a->rtt() + 4 * connection_a->rtt_variation(), rto);
+
+    // two segments, i.e., acknowledged without delay
+    uint8_t bulk[600]{};
+    connection_a->send(bulk);
+
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    network.drop(0);
+    network.drop(0);
+
+    // expiry of the TX timer backs off the timeout
+    usleep((rto + 10) * 1000);
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    EXPECT_EQ(2 * rto, connection_a->retransmission_timeout());
+
+    // ACK of retransmitted data is no sample
+    endpoint_b->rx_burst(8, 0);
+    endpoint_a->rx();
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+    EXPECT_EQ(2 * rto, connection_a->retransmission_timeout());
+
+    // new sample replaces the backed off timeout
+    connection_a->send(bulk);
+
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    endpoint_b->rx_burst(8, 0);
+    endpoint_a->rx();
+    EXPECT_LT(connection_a->rtt(), 20);
+    EXPECT_LT(connection_a->retransmission_timeout(), 2 * rto);
+    EXPECT_GE(connection_a->retransmission_timeout(), space_tcp::DefaultConfig::MIN_RETRANSMISSION_TIMEOUT);
+}
+
+TEST_F(TcpEndpointTest, SequenceWrapAroundTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t bulk[2000]{};
+    uint8_t received[1 << 12]{};
+
+    // transfer more than 64 KiB such that 16-bit sequence numbers wrap around
+    for (auto i = 0; i < 40; i++) {
+        bulk[0] = static_cast<uint8_t>(i);
+
+        ASSERT_EQ(sizeof(bulk), connection_a->send(bulk));
+
+        ASSERT_EQ(4, endpoint_a->tx_burst(8));
+        ASSERT_EQ(4, endpoint_b->rx_burst(8, 0));
+        endpoint_a->rx(0);
+
+        ASSERT_TRUE(connection_a->tx_queue_empty());
+
+        auto len = connection_b->receive(received);
+        ASSERT_EQ(bulk[0], received[len - sizeof(bulk)]);
+
+        // window update for the next round
+        ASSERT_EQ(1, endpoint_b->tx_burst(8));
+        endpoint_a->rx(0);
+    }
+}
+
+TEST_F(TcpEndpointTest, ExtendedSequenceNumbersTest) {
+    uint8_t data[] = "hallo";
+
+    connection_a->use_extended_sequence_numbers(true);
+    connection_b->use_extended_sequence_numbers(true);
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_EQ(space_tcp::State::Established, connection_a->get_state());
+    EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
+    EXPECT_TRUE(connection_a->extended_sequence_numbers());
+    EXPECT_TRUE(connection_b->extended_sequence_numbers());
+
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk);
+
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    EXPECT_EQ(4, endpoint_b->rx_burst(8, 0));
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + sizeof(bulk), connection_b->receive(received));
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, ExtendedSequenceNumbersFallbackTest) {
+    uint8_t data[] = "hallo";
+
+    // listening host does not ask for 32-bit sequence numbers
+    connection_a->use_extended_sequence_numbers(true);
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_EQ(space_tcp::State::Established, connection_a->get_state());
+    EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
+    EXPECT_FALSE(connection_a->extended_sequence_numbers());
+    EXPECT_FALSE(connection_b->extended_sequence_numbers());
+}
+
+TEST_F(TcpEndpointTest, HeaderOptionsFallbackTest) {
+    // options flag of the S3TP header
+    constexpr uint8_t OPT = 0x10;
+
+    uint8_t data[] = "hallo";
+    uint8_t received[sizeof(data)]{};
+
+    // connection_a behaves like a host which does not know header options
+    connection_a->use_header_options(false);
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+
+    // neither the SYN+ACK nor later packets carry options
+    ASSERT_EQ(1, network.queued());
+    EXPECT_EQ(0, network.flags(0) & OPT);
+    EXPECT_FALSE(connection_b->header_options());
+
+    endpoint_a->rx();
+    endpoint_b->rx();
+    EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
+
+    connection_b->send(data);
+    endpoint_b->tx();
+    ASSERT_EQ(1, network.queued());
+    EXPECT_EQ(0, network.flags(0) & OPT);
+
+    endpoint_a->rx();
+    EXPECT_EQ(sizeof(data), connection_a->receive(received));
+    EXPECT_EQ(0, memcmp(data, received, sizeof(data)));
+}
+
+// configuration for a slow link with small packets
+struct SmallConfig : space_tcp::DefaultConfig {
+    static constexpr size_t PAYLOAD_SIZE = 128;
+    static constexpr size_t WINDOW_SIZE = 8;
+    static constexpr size_t BURST_SIZE = 4;
+};
+
+TEST_F(TcpEndpointTest, ConfiguredEndpointTest) {
+    using SmallEndpoint = space_tcp::BasicTcpEndpoint<SmallConfig>;
+
+    EXPECT_EQ(SmallEndpoint::PACKET_OVERHEAD + 128, SmallEndpoint::PACKET_SIZE);
+
+    uint8_t small_buffer_a[4 * SmallEndpoint::PACKET_SIZE]{};
+    uint8_t small_buffer_b[4 * SmallEndpoint::PACKET_SIZE]{};
+    uint8_t small_connection_buffer_a[1 << 12]{};
+    uint8_t small_connection_buffer_b[1 << 12]{};
+    space_tcp::Connections<1, SmallConfig> small_connections_a;
+    space_tcp::Connections<1, SmallConfig> small_connections_b;
+    TestNetwork small_network{};
+
+    auto small_endpoint_a = space_tcp::create_tcp_endpoint(small_buffer_a, small_network, small_connections_a);
+    auto small_endpoint_b = space_tcp::create_tcp_endpoint(small_buffer_b, small_network, small_connections_b);
+
+    auto small_connection_a = space_tcp::create_connection(small_connection_buffer_a, 13, 17, small_endpoint_a);
+    auto small_connection_b = space_tcp::create_connection(small_connection_buffer_b, 17, 13, small_endpoint_b);
+
+    uint8_t data[] = "hallo";
+
+    // endpoints with the default configuration work side by side
+    connection_b->listen();
+    connection_a->send(data);
+    small_connection_b->listen();
+    small_connection_a->send(data);
+
+    endpoint_a->tx();
+    small_endpoint_a.tx();
+    endpoint_b->rx();
+    small_endpoint_b.rx();
+    endpoint_a->rx();
+    small_endpoint_a.rx();
+    endpoint_b->rx();
+    small_endpoint_b.rx();
+
+    EXPECT_EQ(space_tcp::State::Established, connection_b->get_state());
+    EXPECT_EQ(space_tcp::State::Established, small_connection_b->get_state());
+
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk);
+    small_connection_a->send(bulk);
+
+    // 4 * 512 B packets vs. a window of 8 * 128 B packets in bursts of 4
+    EXPECT_EQ(4, endpoint_a->tx_burst(16));
+    EXPECT_EQ(8, small_endpoint_a.tx_burst(16));
+    EXPECT_EQ(0, small_endpoint_a.tx_burst(16));
+
+    EXPECT_EQ(4, small_endpoint_b.rx_burst(16, 0));
+    EXPECT_EQ(4, small_endpoint_b.rx_burst(16, 0));
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + 8 * 128, small_connection_b->receive(received));
+}
+
+TEST_F(TcpEndpointTest, DefaultSegmentSizeTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // network without MTU, endpoints stick to the configured payload size
+    EXPECT_EQ(512, endpoint_a->max_segment_size());
+    EXPECT_EQ(512, connection_a->segment_size());
+    EXPECT_EQ(512, connection_b->segment_size());
+}
+
+TEST_F(TcpEndpointTest, FlowControlTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data), connection_b->receive(received));
+
+    uint8_t bulk[2000], tail[100];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = i % 251;
+    }
+    for (size_t i = 0; i < sizeof(tail); i++) {
+        tail[i] = i % 13;
+    }
+
+    // the receive buffer of B fills up to 48 bytes
+    connection_a->send(bulk);
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    EXPECT_EQ(4, endpoint_b->rx_burst(8, 0));
+    endpoint_a->rx_burst(8, 0);
+
+    // only the advertised window is sent
+    connection_a->send(tail);
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+    endpoint_b->rx(0);
+
+    // delayed ACK closes the window
+    usleep((space_tcp::DefaultConfig::ACK_DELAY + 2) * 1000);
+    EXPECT_EQ(1, endpoint_b->tx_burst(8));
+    endpoint_a->rx(0);
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    // closed window is probed after the retransmission timeout, the probe is
+    // answered right away
+    usleep((connection_a->retransmission_timeout() + 10) * 1000);
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    auto sent = network.sent;
+    endpoint_b->rx(0);
+    EXPECT_EQ(sent + 1, network.sent);
+    endpoint_a->rx(0);
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    // reading opens the window again
+    auto len = connection_b->receive(received);
+    EXPECT_EQ(2048, len);
+    EXPECT_EQ(1, endpoint_b->tx_burst(8));
+    endpoint_a->rx(0);
+
+    // probe and the rest of the data
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    endpoint_b->rx_burst(8, 0);
+    uint8_t rest[1 << 12]{};
+    EXPECT_EQ(52, connection_b->receive(rest));
+
+    EXPECT_EQ(0, memcmp(bulk, received, sizeof(bulk)));
+    EXPECT_EQ(0, memcmp(tail, received + sizeof(bulk), 48));
+    EXPECT_EQ(0, memcmp(tail + 48, rest, 52));
+}
+
+TEST_F(TcpEndpointTest, ZeroCopyTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    space_tcp::const_region readable[2];
+    ASSERT_EQ(sizeof(data), connection_b->peek(readable));
+    EXPECT_EQ(0, memcmp(data, readable[0].data, sizeof(data)));
+    EXPECT_EQ(sizeof(data), connection_b->consume(sizeof(data)));
+
+    // data written in place, wrapping around the end of the transmit buffer
+    // after the first round
+    for (size_t round = 0; round < 3; round++) {
+        space_tcp::region writable[2];
+        ASSERT_EQ(1000, connection_a->reserve(1000, writable));
+
+        for (size_t i = 0; i < 1000; i++) {
+            auto &region = (i < writable[0].len) ? writable[0] : writable[1];
+            region.data[(i < writable[0].len) ? i : i - writable[0].len] = static_cast<uint8_t>(round + i);
+        }
+
+        EXPECT_TRUE(connection_a->commit(1000));
+
+        endpoint_a->tx_burst(8);
+        endpoint_b->rx_burst(8, 0);
+        endpoint_a->rx(0);
+
+        // the receive buffer hands out its data without copying
+        ASSERT_EQ(1000, connection_b->peek(readable));
+
+        for (size_t i = 0; i < 1000; i++) {
+            auto &region = (i < readable[0].len) ? readable[0] : readable[1];
+            ASSERT_EQ(static_cast<uint8_t>(round + i), region.data[(i < readable[0].len) ? i : i - readable[0].len]);
+        }
+
+        EXPECT_EQ(1000, connection_b->consume(1000));
+    }
+
+    EXPECT_FALSE(connection_a->commit(1 << 12));
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, GatheredSendTest) {
+    uint8_t header[] = "header:";
+    uint8_t body[] = "payload of the frame";
+
+    connection_b->listen();
+
+    space_tcp::const_region frame[] = {{header, sizeof(header) - 1}, {nullptr, 0}, {body, sizeof(body)}};
+    EXPECT_EQ(sizeof(header) - 1 + sizeof(body), connection_a->send(frame, 3));
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    // scattered to a small and a large buffer
+    uint8_t first[4], second[64];
+    space_tcp::region buffers[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+    EXPECT_EQ(sizeof(header) - 1 + sizeof(body), connection_b->receive(buffers, 2));
+
+    EXPECT_EQ(0, memcmp("head", first, sizeof(first)));
+    EXPECT_EQ(0, memcmp("er:", second, 3));
+    EXPECT_EQ(0, memcmp(body, second + 3, sizeof(body)));
+}
+
+TEST_F(TcpEndpointTest, ApplicationThreadsTest) {
+    constexpr size_t TOTAL = 20000;
+
+    connection_b->listen();
+
+    std::atomic<size_t> received{};
+    std::atomic<bool> stop{};
+    bool in_order = true;
+
+    // one thread sends, another one receives while this one drives the
+    // endpoints
+    std::thread sender{[this, &stop] {
+        uint8_t chunk[500];
+        size_t sent = 0;
+
+        while (sent < TOTAL && !stop) {
+            for (size_t i = 0; i < sizeof(chunk); i++) {
+                chunk[i] = static_cast<uint8_t>((sent + i) % 251);
+            }
+
+            auto len = (TOTAL - sent < sizeof(chunk)) ? TOTAL - sent : sizeof(chunk);
+            auto pushed = connection_a->send(chunk, len);
+
+            if (pushed > 0) {
+                sent += pushed;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    std::thread receiver{[this, &received, &stop, &in_order] {
+        uint8_t chunk[300];
+
+        while (received < TOTAL && !stop) {
+            auto len = connection_b->receive(chunk);
+
+            for (ssize_t i = 0; i < len; i++) {
+                in_order &= chunk[i] == static_cast<uint8_t>((received + i) % 251);
+            }
+
+            received += len;
+
+            if (len == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    for (size_t round = 0; round < 100000 && received < TOTAL; round++) {
+        endpoint_a->tx_burst(8);
+        endpoint_b->rx_burst(8, 0);
+        endpoint_b->tx_burst(8);
+        endpoint_a->rx_burst(8, 0);
+        usleep(100);
+    }
+
+    stop = true;
+    sender.join();
+    receiver.join();
+
+    EXPECT_EQ(TOTAL, received);
+    EXPECT_TRUE(in_order);
+}
+
+TEST_F(TcpEndpointTest, ForwardErrorCorrectionTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data), connection_b->receive(received));
+
+    uint8_t fec_buffer_a[1 << 11], fec_buffer_b[1 << 11];
+    auto fec_a = space_tcp::ForwardErrorCorrection::create(fec_buffer_a, sizeof(fec_buffer_a));
+    auto fec_b = space_tcp::ForwardErrorCorrection::create(fec_buffer_b, sizeof(fec_buffer_b));
+    connection_a->set_forward_error_correction(&fec_a);
+    connection_b->set_forward_error_correction(&fec_b);
+
+    fec_a.set_code_rate(4, 1);
+
+    // four segments and their repair packet
+    uint8_t bulk[2000];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = i % 251;
+    }
+
+    connection_a->send(bulk);
+    EXPECT_EQ(5, endpoint_a->tx_burst(8));
+
+    // the lost segment is rebuilt without retransmission
+    network.drop(1);
+    EXPECT_EQ(4, endpoint_b->rx_burst(8, 0));
+    EXPECT_EQ(1, fec_b.recovered());
+
+    EXPECT_EQ(sizeof(bulk), connection_b->receive(received));
+    EXPECT_EQ(0, memcmp(bulk, received, sizeof(bulk)));
+
+    endpoint_a->rx_burst(8, 0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, CompressionTest) {
+    uint8_t data[] = "hallo";
+
+    connection_a->use_compression(true);
+    connection_b->use_compression(true);
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_TRUE(connection_a->compressed());
+    EXPECT_TRUE(connection_b->compressed());
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data), connection_b->receive(received));
+
+    const char text[] = "housekeeping telemetry frame: battery nominal, attitude nominal; ";
+
+    uint8_t bulk[2000];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = static_cast<uint8_t>(text[i % (sizeof(text) - 1)]);
+    }
+
+    connection_a->send(bulk);
+
+    // segments keep their size in sequence space, not on the wire
+    auto sent_bytes = network.sent_bytes;
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    EXPECT_LT(network.sent_bytes - sent_bytes, sizeof(bulk) / 2);
+
+    // the retransmission of the lost segment is compressed, too
+    network.drop(1);
+    EXPECT_EQ(3, endpoint_b->rx_burst(8, 0));
+
+    endpoint_a->rx(0);
+    usleep((connection_a->retransmission_timeout() + 10) * 1000);
+
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(1, endpoint_b->rx_burst(8, 0));
+
+    EXPECT_EQ(sizeof(bulk), connection_b->receive(received));
+    EXPECT_EQ(0, memcmp(bulk, received, sizeof(bulk)));
+
+    endpoint_a->rx(0);
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+}
+
+TEST_F(TcpEndpointTest, CompressionFallbackTest) {
+    uint8_t data[] = "hallo";
+
+    // listening host does not ask for compression
+    connection_a->use_compression(true);
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_EQ(space_tcp::State::Established, connection_a->get_state());
+    EXPECT_FALSE(connection_a->compressed());
+    EXPECT_FALSE(connection_b->compressed());
+
+    uint8_t bulk[1000]{};
+    connection_a->send(bulk);
+
+    auto sent_bytes = network.sent_bytes;
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    EXPECT_GT(network.sent_bytes - sent_bytes, sizeof(bulk));
+
+    EXPECT_EQ(2, endpoint_b->rx_burst(8, 0));
+
+    uint8_t received[1 << 12]{};
+    EXPECT_EQ(sizeof(data) + sizeof(bulk), connection_b->receive(received));
+}
+
+TEST_F(TcpEndpointTest, FountainTest) {
+    uint8_t object[3000];
+    for (size_t i = 0; i < sizeof(object); i++) {
+        object[i] = i % 253;
+    }
+
+    uint8_t rebuilt[3000]{};
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 500);
+    auto decoder = space_tcp::FountainDecoder::create(rebuilt, sizeof(rebuilt));
+
+    // no handshake, A streams symbols right away
+    EXPECT_TRUE(connection_b->receive_object(&decoder));
+    EXPECT_TRUE(connection_a->send_object(&encoder));
+    EXPECT_EQ(space_tcp::State::Fountain, connection_a->get_state());
+
+    // a third of the symbols is lost
+    for (auto i = 0; i < 10 && !decoder.complete(); i++) {
+        EXPECT_EQ(3, endpoint_a->tx_burst(3));
+        network.drop(1);
+        endpoint_b->rx_burst(8, 0);
+    }
+
+    ASSERT_TRUE(decoder.complete());
+    EXPECT_EQ(0, memcmp(object, rebuilt, sizeof(object)));
+
+    // feedback of B stops A
+    EXPECT_EQ(1, network.queued());
+    endpoint_a->rx(0);
+    EXPECT_EQ(space_tcp::State::Closed, connection_a->get_state());
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+}
+
+TEST_F(TcpEndpointTest, FountainWithoutFeedbackTest) {
+    uint8_t object[1000]{};
+    uint8_t rebuilt[1024]{};
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 256);
+    auto decoder = space_tcp::FountainDecoder::create(rebuilt, sizeof(rebuilt));
+
+    EXPECT_TRUE(connection_b->receive_object(&decoder, false));
+    EXPECT_TRUE(connection_a->send_object(&encoder, 6));
+
+    // the transfer ends after the given number of symbols
+    EXPECT_EQ(6, endpoint_a->tx_burst(8));
+    EXPECT_EQ(space_tcp::State::Closed, connection_a->get_state());
+
+    EXPECT_EQ(6, endpoint_b->rx_burst(8, 0));
+    EXPECT_TRUE(decoder.complete());
+    EXPECT_EQ(0, network.queued());
+
+    connection_b->close();
+    EXPECT_EQ(space_tcp::State::Closed, connection_b->get_state());
+}
+
+TEST_F(TcpEndpointTest, FountainOversizedObjectTest) {
+    uint8_t object[space_tcp::FOUNTAIN_MAX_BLOCKS * 16 + 1]{};
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 16);
+
+    // the object is not sent in part
+    EXPECT_FALSE(connection_a->send_object(&encoder));
+    EXPECT_EQ(space_tcp::State::Closed, connection_a->get_state());
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+}
+
+TEST_F(TcpEndpointTest, PacedConnectionTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    EXPECT_EQ(UINT64_MAX, endpoint_a->next_deadline());
+
+    // 100 KB/s with bursts of four segments
+    connection_a->set_rate(100000);
+    EXPECT_EQ(100000, connection_a->rate());
+
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk);
+    EXPECT_EQ(4, endpoint_a->tx_burst(8));
+    endpoint_b->rx_burst(8, 0);
+    endpoint_a->rx(0);
+
+    uint8_t received[1 << 12]{};
+    connection_b->receive(received);
+    endpoint_b->tx_burst(8);
+    endpoint_a->rx(0);
+
+    // burst used up, next segment is due once the bucket refilled
+    connection_a->send(bulk);
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    auto now = space_tcp::Time::get_time_in_ms();
+    auto deadline = endpoint_a->next_deadline();
+    EXPECT_GT(deadline, now);
+    EXPECT_LE(deadline, now + 30);
+
+    usleep((deadline - now + 1) * 1000);
+    EXPECT_LE(1, endpoint_a->tx_burst(8));
+
+    // unpaced connection sends the rest at once
+    connection_a->set_rate(0);
+    EXPECT_LE(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+}
+
+TEST_F(TcpEndpointTest, CongestionControlTest) {
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a->tx();
+    endpoint_b->rx();
+    endpoint_a->rx();
+    endpoint_b->rx();
+
+    auto controller = space_tcp::AimdController::create();
+    connection_a->set_congestion_controller(&controller);
+
+    EXPECT_EQ(4 * connection_a->segment_size(), controller.window());
+
+    // ACK grows the window
+    uint8_t bulk[2000]{};
+    connection_a->send(bulk, 1000);
+
+    EXPECT_EQ(2, endpoint_a->tx_burst(8));
+    endpoint_b->rx_burst(8, 0);
+    endpoint_a->rx(0);
+
+    EXPECT_TRUE(connection_a->tx_queue_empty());
+    EXPECT_EQ(5 * connection_a->segment_size(), controller.window());
+
+    uint8_t received[1 << 12]{};
+    connection_b->receive(received);
+    endpoint_b->tx_burst(8);
+    endpoint_a->rx(0);
+
+    // window of a single segment caps the data in flight
+    controller.timed_out(0);
+    connection_a->send(bulk);
+
+    EXPECT_EQ(1, endpoint_a->tx_burst(8));
+    EXPECT_EQ(0, endpoint_a->tx_burst(8));
+
+    // without controller, the static window applies again
+    connection_a->set_congestion_controller(nullptr);
+    EXPECT_EQ(3, endpoint_a->tx_burst(8));
+}
+
+TEST(TcpEndpointPacingTest, NetworkRateTest) {
+    TestNetwork network{};
+    network.link_rate = 200000;
+
+    uint8_t buffer_a[1 << 12]{}, buffer_b[1 << 12]{};
+    uint8_t connection_buffer_a[1 << 14]{}, connection_buffer_b[1 << 14]{};
+    space_tcp::Connections<1> connections_a, connections_b;
+
+    auto endpoint_a = space_tcp::create_tcp_endpoint(buffer_a, network, connections_a);
+    auto endpoint_b = space_tcp::create_tcp_endpoint(buffer_b, network, connections_b);
+
+    auto connection_a = space_tcp::create_connection(connection_buffer_a, 13, 17, endpoint_a);
+    auto connection_b = space_tcp::create_connection(connection_buffer_b, 17, 13, endpoint_b);
+
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a.tx();
+    endpoint_b.rx(0);
+    endpoint_a.rx(0);
+    endpoint_b.rx(0);
+
+    // sixteen segments, four of them fit into the burst
+    static uint8_t bulk[16 * 512];
+    EXPECT_EQ(sizeof(bulk), connection_a->send(bulk));
+
+    auto start = space_tcp::Time::get_time_in_us();
+    size_t sent = endpoint_a.tx_burst(32);
+    EXPECT_LT(sent, 16);
+
+    while (sent < 16) {
+        auto deadline = endpoint_a.next_deadline();
+        auto now = space_tcp::Time::get_time_in_ms();
+
+        ASSERT_NE(UINT64_MAX, deadline);
+
+        if (deadline > now) {
+            usleep((deadline - now) * 1000);
+        }
+
+        sent += endpoint_a.tx_burst(32);
+    }
+
+    // the segments after the burst, i.e., more than 5 KB, take more than 25 ms
+    // at 200 KB/s
+    EXPECT_GE(space_tcp::Time::get_time_in_us() - start, 25000);
+}
+
+TEST(TcpEndpointMtuTest, LargePayloadTest) {
+    // loopback-class network with 64 KiB packets
+    TestNetwork network{0xffff};
+
+    std::vector<uint8_t> buffer_a(1 << 17), buffer_b(1 << 17);
+    std::vector<uint8_t> connection_buffer_a(1 << 18), connection_buffer_b(1 << 18);
+    space_tcp::Connections<1> connections_a, connections_b;
+
+    auto endpoint_a = space_tcp::TcpEndpoint::create(buffer_a.data(), buffer_a.size(), connections_a, network);
+    auto endpoint_b = space_tcp::TcpEndpoint::create(buffer_b.data(), buffer_b.size(), connections_b, network);
+
+    EXPECT_EQ(space_tcp::DefaultConfig::MAX_PAYLOAD_SIZE, endpoint_a.max_segment_size());
+
+    auto connection_a = endpoint_a.create_connection(connection_buffer_a.data(), connection_buffer_a.size(), 13, 17);
+    auto connection_b = endpoint_b.create_connection(connection_buffer_b.data(), connection_buffer_b.size(), 17, 13);
+
+    connection_a->use_extended_sequence_numbers(true);
+    connection_b->use_extended_sequence_numbers(true);
+
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a.tx();
+    endpoint_b.rx(0);
+    endpoint_a.rx(0);
+    endpoint_b.rx(0);
+
+    ASSERT_EQ(space_tcp::State::Established, connection_b->get_state());
+    EXPECT_EQ(space_tcp::DefaultConfig::MAX_PAYLOAD_SIZE, connection_a->segment_size());
+
+    // 60 KB in a single packet
+    static uint8_t bulk[60000];
+    for (size_t i = 0; i < sizeof(bulk); i++) {
+        bulk[i] = static_cast<uint8_t>(i);
+    }
+
+    EXPECT_EQ(sizeof(bulk), connection_a->send(bulk));
+    EXPECT_EQ(1, endpoint_a.tx_burst(8));
+    EXPECT_EQ(1, endpoint_b.rx_burst(8, 0));
+
+    static uint8_t received[sizeof(data) + sizeof(bulk)];
+    EXPECT_EQ(sizeof(received), connection_b->receive(received));
+    EXPECT_EQ(0, memcmp(received + sizeof(data), bulk, sizeof(bulk)));
+}
+
+TEST(TcpEndpointMtuTest, NegotiatedSegmentSizeTest) {
+    TestNetwork network{1500};
+
+    // endpoint b only has room for small packets
+    uint8_t buffer_a[1 << 12]{}, buffer_b[1 << 10]{};
+    uint8_t connection_buffer_a[1 << 12]{}, connection_buffer_b[1 << 12]{};
+    space_tcp::Connections<1> connections_a, connections_b;
+
+    auto endpoint_a = space_tcp::create_tcp_endpoint(buffer_a, network, connections_a);
+    auto endpoint_b = space_tcp::create_tcp_endpoint(buffer_b, network, connections_b);
+
+    EXPECT_EQ(1500 - space_tcp::TcpEndpoint::PACKET_OVERHEAD, endpoint_a.max_segment_size());
+    EXPECT_EQ(sizeof(buffer_b) - space_tcp::TcpEndpoint::PACKET_OVERHEAD, endpoint_b.max_segment_size());
+
+    auto connection_a = space_tcp::create_connection(connection_buffer_a, 13, 17, endpoint_a);
+    auto connection_b = space_tcp::create_connection(connection_buffer_b, 17, 13, endpoint_b);
+
+    uint8_t data[] = "hallo";
+
+    connection_b->listen();
+    connection_a->send(data);
+
+    endpoint_a.tx();
+    endpoint_b.rx(0);
+    endpoint_a.rx(0);
+    endpoint_b.rx(0);
+
+    ASSERT_EQ(space_tcp::State::Established, connection_b->get_state());
+
+    // both directions use the smaller segment size
+    EXPECT_EQ(endpoint_b.max_segment_size(), connection_a->segment_size());
+    EXPECT_EQ(endpoint_b.max_segment_size(), connection_b->segment_size());
+
+    uint8_t bulk[1500]{};
+    connection_a->send(bulk);
+
+    EXPECT_EQ(2, endpoint_a.tx_burst(8));
+    EXPECT_EQ(1, endpoint_b.rx_burst(8, 0));
+    EXPECT_EQ(1, endpoint_b.rx_burst(8, 0));
+
+    uint8_t received[1 << 11]{};
+    EXPECT_EQ(sizeof(data) + sizeof(bulk), connection_b->receive(received));
+}
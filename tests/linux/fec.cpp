@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/fec.hpp"
+
+// Sends `count` segments of `len` bytes filled with their index through
+// `fec`, starting at sequence number `seq`.
+static void send_segments(space_tcp::ForwardErrorCorrection &fec, size_t count, size_t len, uint32_t seq = 1000) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t payload[64];
+        memset(payload, static_cast<int>(i + 1), sizeof(payload));
+
+        space_tcp::fec_tag tag{};
+        ASSERT_TRUE(fec.tx_tag(tag));
+        EXPECT_EQ(i, tag.index);
+
+        fec.sent(seq + i * len, payload, len);
+    }
+}
+
+TEST(ForwardErrorCorrectionTest, CodeRate) {
+    uint8_t buffer[256];
+    auto fec = space_tcp::ForwardErrorCorrection::create(buffer, sizeof(buffer));
+
+    EXPECT_FALSE(fec.enabled());
+
+    space_tcp::fec_tag tag{};
+    EXPECT_FALSE(fec.tx_tag(tag));
+
+    fec.set_code_rate(8, 2);
+    EXPECT_TRUE(fec.enabled());
+    EXPECT_EQ(8, fec.data_segments());
+    EXPECT_EQ(2, fec.repair_segments());
+
+    // a repair segment covers up to MAX_LANE_SEGMENTS data segments
+    fec.set_code_rate(32, 1);
+    EXPECT_EQ(space_tcp::ForwardErrorCorrection::MAX_GROUP_SIZE, fec.data_segments());
+    EXPECT_EQ(2, fec.repair_segments());
+}
+
+TEST(ForwardErrorCorrectionTest, RepairSegments) {
+    uint8_t buffer[256];
+    auto fec = space_tcp::ForwardErrorCorrection::create(buffer, sizeof(buffer));
+    fec.set_code_rate(4, 2);
+
+    send_segments(fec, 3, 32);
+    EXPECT_FALSE(fec.repair_pending());
+
+    // the last segment of the group is shorter
+    uint8_t last[16];
+    memset(last, 4, sizeof(last));
+
+    space_tcp::fec_tag tag{};
+    ASSERT_TRUE(fec.tx_tag(tag));
+    fec.sent(1096, last, sizeof(last));
+
+    EXPECT_TRUE(fec.repair_pending());
+    EXPECT_FALSE(fec.tx_tag(tag));
+
+    // lane 0 covers segments 0 and 2, lane 1 segments 1 and 3
+    space_tcp::ForwardErrorCorrection::repair_segment repair{};
+    ASSERT_TRUE(fec.next_repair(repair));
+    EXPECT_EQ(0, repair.tag.group);
+    EXPECT_EQ(0, repair.tag.index);
+    ASSERT_EQ(2, repair.count);
+    EXPECT_EQ(1000u, repair.segments[0].start);
+    EXPECT_EQ(1064u, repair.segments[1].start);
+    ASSERT_EQ(32, repair.len);
+    EXPECT_EQ(1 ^ 3, repair.payload[0]);
+
+    ASSERT_TRUE(fec.next_repair(repair));
+    EXPECT_EQ(1, repair.tag.index);
+    EXPECT_EQ(1096u, repair.segments[1].start);
+    EXPECT_EQ(1112u, repair.segments[1].end);
+    ASSERT_EQ(32, repair.len);
+    EXPECT_EQ(2 ^ 4, repair.payload[0]);
+    EXPECT_EQ(2, repair.payload[16]);
+
+    EXPECT_FALSE(fec.next_repair(repair));
+
+    // next group
+    ASSERT_TRUE(fec.tx_tag(tag));
+    EXPECT_EQ(1, tag.group);
+    EXPECT_EQ(0, tag.index);
+}
+
+TEST(ForwardErrorCorrectionTest, Recover) {
+    uint8_t tx_buffer[256], rx_buffer[256];
+    auto tx = space_tcp::ForwardErrorCorrection::create(tx_buffer, sizeof(tx_buffer));
+    auto rx = space_tcp::ForwardErrorCorrection::create(rx_buffer, sizeof(rx_buffer));
+    tx.set_code_rate(4, 2);
+
+    send_segments(tx, 4, 32);
+
+    // segments 1 and 2 lost, one per lane
+    for (uint8_t i : {0, 3}) {
+        uint8_t payload[32];
+        memset(payload, i + 1, sizeof(payload));
+
+        rx.received({0, i, 2}, payload, sizeof(payload));
+    }
+
+    space_tcp::ForwardErrorCorrection::repair_segment repair{};
+
+    for (auto lost : {2, 1}) {
+        ASSERT_TRUE(tx.next_repair(repair));
+
+        uint8_t payload[32];
+        memcpy(payload, repair.payload, repair.len);
+
+        auto i = rx.recover(repair.tag, repair.segments, repair.count, payload, repair.len);
+        ASSERT_EQ(lost / 2, i);
+        EXPECT_EQ(lost + 1, payload[0]);
+        EXPECT_EQ(lost + 1, payload[31]);
+
+        // rebuilt once only
+        EXPECT_EQ(repair.count, rx.recover(repair.tag, repair.segments, repair.count, payload, repair.len));
+    }
+
+    EXPECT_EQ(2, rx.recovered());
+}
+
+TEST(ForwardErrorCorrectionTest, TwoLossesInLane) {
+    uint8_t tx_buffer[256], rx_buffer[256];
+    auto tx = space_tcp::ForwardErrorCorrection::create(tx_buffer, sizeof(tx_buffer));
+    auto rx = space_tcp::ForwardErrorCorrection::create(rx_buffer, sizeof(rx_buffer));
+    tx.set_code_rate(3, 1);
+
+    send_segments(tx, 3, 32);
+
+    uint8_t payload[32];
+    memset(payload, 1, sizeof(payload));
+    rx.received({0, 0, 1}, payload, sizeof(payload));
+
+    space_tcp::ForwardErrorCorrection::repair_segment repair{};
+    ASSERT_TRUE(tx.next_repair(repair));
+
+    memcpy(payload, repair.payload, repair.len);
+    EXPECT_EQ(repair.count, rx.recover(repair.tag, repair.segments, repair.count, payload, repair.len));
+    EXPECT_EQ(0, rx.recovered());
+}
+
+TEST(ForwardErrorCorrectionTest, RepairAfterNextGroup) {
+    uint8_t tx_buffer[256], rx_buffer[256];
+    auto tx = space_tcp::ForwardErrorCorrection::create(tx_buffer, sizeof(tx_buffer));
+    auto rx = space_tcp::ForwardErrorCorrection::create(rx_buffer, sizeof(rx_buffer));
+    tx.set_code_rate(2, 1);
+
+    send_segments(tx, 2, 32);
+
+    space_tcp::ForwardErrorCorrection::repair_segment repair{};
+    ASSERT_TRUE(tx.next_repair(repair));
+
+    // segment 1 of group 0 lost, the first segment of group 1 overtakes the
+    // repair segment of group 0
+    uint8_t payload[32];
+    memset(payload, 1, sizeof(payload));
+    rx.received({0, 0, 1}, payload, sizeof(payload));
+    rx.received({1, 0, 1}, payload, sizeof(payload));
+
+    memcpy(payload, repair.payload, repair.len);
+    ASSERT_EQ(1, rx.recover(repair.tag, repair.segments, repair.count, payload, repair.len));
+    EXPECT_EQ(2, payload[0]);
+    EXPECT_EQ(2, payload[31]);
+
+    // group 2 replaces group 0, its repair segment is ignored
+    rx.received({2, 0, 1}, payload, sizeof(payload));
+    memcpy(payload, repair.payload, repair.len);
+    EXPECT_EQ(repair.count, rx.recover(repair.tag, repair.segments, repair.count, payload, repair.len));
+
+    // late segments of group 0 do not replace group 2, whose received
+    // segment needs no repair
+    rx.received({0, 1, 1}, payload, sizeof(payload));
+
+    space_tcp::seq_range segment{2000, 2032};
+    EXPECT_EQ(1, rx.recover({2, 0, 1}, &segment, 1, payload, sizeof(payload)));
+    EXPECT_EQ(1, rx.recovered());
+}
+
+TEST(ForwardErrorCorrectionTest, Adaptive) {
+    uint8_t buffer[512];
+    auto fec = space_tcp::ForwardErrorCorrection::create(buffer, sizeof(buffer));
+    fec.set_code_rate(4, 1);
+    fec.set_adaptive(true);
+
+    space_tcp::ForwardErrorCorrection::repair_segment repair{};
+
+    // retransmissions add a repair segment
+    fec.retransmitted();
+    send_segments(fec, 4, 32);
+    EXPECT_EQ(2, fec.repair_segments());
+
+    while (fec.next_repair(repair)) {
+    }
+
+    // groups without retransmission remove it again
+    for (size_t i = 0; i < space_tcp::ForwardErrorCorrection::ADAPTATION_GROUPS; i++) {
+        EXPECT_EQ(2, fec.repair_segments());
+
+        send_segments(fec, 4, 32);
+        while (fec.next_repair(repair)) {
+        }
+    }
+
+    EXPECT_EQ(1, fec.repair_segments());
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/fountain.hpp"
+
+class FountainTest : public ::testing::Test {
+public:
+    FountainTest() {
+        for (size_t i = 0; i < sizeof(object); i++) {
+            object[i] = static_cast<uint8_t>(i * 7 + i / 256);
+        }
+    }
+
+protected:
+    // 10 blocks of 100 bytes, the last one is short
+    uint8_t object[950]{};
+    uint8_t buffer[1000]{};
+};
+
+TEST_F(FountainTest, Coefficients) {
+    // systematic symbols first
+    EXPECT_EQ(1u, space_tcp::fountain_coefficients(0, 10));
+    EXPECT_EQ(1u << 9, space_tcp::fountain_coefficients(9, 10));
+
+    for (uint32_t id = 10; id < 1000; id++) {
+        auto coefficients = space_tcp::fountain_coefficients(id, 10);
+
+        EXPECT_NE(0u, coefficients);
+        EXPECT_EQ(0u, coefficients >> 10);
+    }
+}
+
+TEST_F(FountainTest, Systematic) {
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 100);
+    auto decoder = space_tcp::FountainDecoder::create(buffer, sizeof(buffer));
+
+    EXPECT_EQ(10, encoder.blocks());
+
+    uint8_t symbol[100];
+
+    for (uint32_t id = 0; id < 10; id++) {
+        EXPECT_FALSE(decoder.complete());
+
+        ASSERT_EQ(100, encoder.symbol(id, symbol));
+        EXPECT_TRUE(decoder.add(id, sizeof(object), symbol, sizeof(symbol)));
+    }
+
+    ASSERT_TRUE(decoder.complete());
+    EXPECT_EQ(sizeof(object), decoder.object_size());
+    EXPECT_EQ(0, memcmp(object, buffer, sizeof(object)));
+}
+
+TEST_F(FountainTest, AnySufficientSubset) {
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 100);
+    auto decoder = space_tcp::FountainDecoder::create(buffer, sizeof(buffer));
+
+    uint8_t symbol[100];
+    uint32_t id = 0;
+
+    // every second symbol is lost
+    for (; !decoder.complete() && id < 100; id += 2) {
+        encoder.symbol(id, symbol);
+        decoder.add(id, sizeof(object), symbol, sizeof(symbol));
+    }
+
+    ASSERT_TRUE(decoder.complete());
+    EXPECT_LT(id / 2, 10 + 10);
+    EXPECT_EQ(0, memcmp(object, buffer, sizeof(object)));
+
+    // further symbols are not needed
+    encoder.symbol(id, symbol);
+    EXPECT_FALSE(decoder.add(id, sizeof(object), symbol, sizeof(symbol)));
+}
+
+TEST_F(FountainTest, DependentSymbol) {
+    auto encoder = space_tcp::FountainEncoder::create(object, sizeof(object), 100);
+    auto decoder = space_tcp::FountainDecoder::create(buffer, sizeof(buffer));
+
+    uint8_t symbol[100];
+
+    encoder.symbol(3, symbol);
+    EXPECT_TRUE(decoder.add(3, sizeof(object), symbol, sizeof(symbol)));
+
+    encoder.symbol(3, symbol);
+    EXPECT_FALSE(decoder.add(3, sizeof(object), symbol, sizeof(symbol)));
+    EXPECT_EQ(1, decoder.received_symbols());
+}
+
+TEST_F(FountainTest, ObjectLayout) {
+    auto decoder = space_tcp::FountainDecoder::create(buffer, sizeof(buffer));
+
+    uint8_t symbol[100]{};
+
+    // object larger than the buffer
+    EXPECT_FALSE(decoder.add(0, 2000, symbol, sizeof(symbol)));
+
+    // symbols of another object
+    EXPECT_TRUE(decoder.add(0, 950, symbol, sizeof(symbol)));
+    EXPECT_FALSE(decoder.add(1, 900, symbol, sizeof(symbol)));
+    EXPECT_FALSE(decoder.add(1, 950, symbol, 50));
+
+    decoder.reset();
+    EXPECT_TRUE(decoder.add(1, 900, symbol, sizeof(symbol)));
+}
+
+TEST_F(FountainTest, OversizedObject) {
+    // one block more than an object may have
+    auto encoder = space_tcp::FountainEncoder::create(object, space_tcp::FOUNTAIN_MAX_BLOCKS * 10 + 1, 10);
+
+    uint8_t symbol[10]{};
+
+    EXPECT_EQ(0, encoder.blocks());
+    EXPECT_EQ(0, encoder.symbol(0, symbol));
+
+    // the largest object is accepted
+    encoder = space_tcp::FountainEncoder::create(object, space_tcp::FOUNTAIN_MAX_BLOCKS * 10, 10);
+    EXPECT_EQ(space_tcp::FOUNTAIN_MAX_BLOCKS, encoder.blocks());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/list.hpp"
+
+struct Node {
+    int value{};
+    space_tcp::ListHook<Node> hook;
+};
+
+using List = space_tcp::IntrusiveList<Node, &Node::hook>;
+
+TEST(ListTest, Empty) {
+    List list;
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(0, list.size());
+    EXPECT_EQ(nullptr, list.front());
+    EXPECT_EQ(nullptr, list.pop_front());
+}
+
+TEST(ListTest, PushAndPop) {
+    List list;
+    Node a, b, c;
+    a.value = 1;
+    b.value = 2;
+    c.value = 3;
+
+    EXPECT_TRUE(list.push_back(&a));
+    EXPECT_TRUE(list.push_back(&b));
+    EXPECT_TRUE(list.push_back(&c));
+    EXPECT_EQ(3, list.size());
+
+    EXPECT_EQ(&a, list.pop_front());
+    EXPECT_EQ(&b, list.pop_front());
+    EXPECT_EQ(&c, list.pop_front());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(ListTest, PushLinkedElement) {
+    List list;
+    Node a;
+
+    EXPECT_TRUE(list.push_back(&a));
+    EXPECT_FALSE(list.push_back(&a));
+    EXPECT_EQ(1, list.size());
+    EXPECT_TRUE(List::contains(&a));
+}
+
+TEST(ListTest, Remove) {
+    List list;
+    Node a, b, c;
+    a.value = 1;
+    b.value = 2;
+    c.value = 3;
+
+    list.push_back(&a);
+    list.push_back(&b);
+    list.push_back(&c);
+
+    EXPECT_TRUE(list.remove(&b));
+    EXPECT_FALSE(list.remove(&b));
+    EXPECT_FALSE(List::contains(&b));
+    EXPECT_EQ(&c, List::next(&a));
+    EXPECT_EQ(&a, List::prev(&c));
+
+    EXPECT_TRUE(list.remove(&c));
+    EXPECT_EQ(&a, list.back());
+
+    EXPECT_TRUE(list.remove(&a));
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(nullptr, list.back());
+}
+
+TEST(ListTest, InsertBefore) {
+    List list;
+    Node a, b, c;
+    a.value = 1;
+    b.value = 2;
+    c.value = 3;
+
+    list.push_back(&c);
+    list.insert_before(&c, &a);
+    list.insert_before(&c, &b);
+
+    EXPECT_EQ(1, list.pop_front()->value);
+    EXPECT_EQ(2, list.pop_front()->value);
+    EXPECT_EQ(3, list.pop_front()->value);
+}
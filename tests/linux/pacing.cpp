@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/pacing.hpp"
+
+TEST(TokenBucketTest, Disabled) {
+    auto bucket = space_tcp::TokenBucket::create(0, 1000);
+
+    EXPECT_FALSE(bucket.enabled());
+
+    bucket.consume(1 << 20, 0);
+
+    EXPECT_TRUE(bucket.ready(0));
+    EXPECT_EQ(0, bucket.release_time(0));
+}
+
+TEST(TokenBucketTest, Burst) {
+    // 1 MB/s, bursts of 3000 B
+    auto bucket = space_tcp::TokenBucket::create(1000000, 3000);
+
+    EXPECT_TRUE(bucket.enabled());
+    EXPECT_EQ(1000000, bucket.get_rate());
+
+    // three packets back to back, the third one goes into debt
+    for (auto i = 0; i < 3; i++) {
+        EXPECT_TRUE(bucket.ready(0));
+        bucket.consume(1200, 0);
+    }
+
+    EXPECT_FALSE(bucket.ready(0));
+
+    // 600 B of debt at 1 B/us
+    EXPECT_EQ(600, bucket.release_time(0));
+    EXPECT_FALSE(bucket.ready(599));
+    EXPECT_TRUE(bucket.ready(600));
+}
+
+TEST(TokenBucketTest, Rate) {
+    // 10 KB/s, bursts of a single packet
+    auto bucket = space_tcp::TokenBucket::create(10000, 1000);
+
+    uint64_t time = 0;
+
+    for (auto i = 0; i < 10; i++) {
+        time = bucket.release_time(time);
+        bucket.consume(1000, time);
+    }
+
+    // the packet emptying the bucket and the one going into debt leave at
+    // once, afterwards one packet every 100 ms
+    EXPECT_EQ(800000, time);
+}
+
+TEST(TokenBucketTest, RefillIsCapped) {
+    auto bucket = space_tcp::TokenBucket::create(1000, 2000);
+
+    bucket.consume(2000, 0);
+
+    // idle for a long time, only one burst is sent back to back
+    EXPECT_TRUE(bucket.ready(1000000000));
+    bucket.consume(2000, 1000000000);
+    bucket.consume(1, 1000000000);
+
+    EXPECT_FALSE(bucket.ready(1000000000));
+    EXPECT_EQ(1000000000 + 1000, bucket.release_time(1000000000));
+}
@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 
+#include "space_tcp/mirror.hpp"
 #include "space_tcp/ring.hpp"
 
+#include <cstring>
+#include <thread>
+#include <vector>
+
 TEST(RingTest, FreeSpaceEmpty) {
     uint8_t mem[4]{};
 
@@ -142,3 +147,202 @@ TEST(RingTest, PushAndPopData) {
     EXPECT_EQ('d', data[2]);
     EXPECT_EQ('a', data[3]);
 }
+
+TEST(RingTest, Peek) {
+    uint8_t mem[8]{};
+
+    auto ring = space_tcp::RingBuffer::create(mem, sizeof(mem));
+
+    uint8_t data[] = "abcdefgh";
+    size_t len;
+
+    EXPECT_EQ(nullptr, ring.peek(0, len));
+    EXPECT_EQ(0, len);
+
+    ring.push_back(data, 6);
+    ring.pop_front(nullptr, 4);
+    ring.push_back(data, 4);
+
+    // "efab" at the end of the buffer, "cd" wrapped around to its start
+    EXPECT_EQ(mem + 4, ring.peek(0, len));
+    EXPECT_EQ(4, len);
+    EXPECT_EQ(mem + 5, ring.peek(1, len));
+    EXPECT_EQ(3, len);
+    EXPECT_EQ(mem + 0, ring.peek(4, len));
+    EXPECT_EQ(2, len);
+    EXPECT_EQ(nullptr, ring.peek(6, len));
+}
+
+TEST(RingTest, WritableRegions) {
+    uint8_t mem[8]{};
+
+    auto ring = space_tcp::RingBuffer::create(mem, sizeof(mem));
+
+    uint8_t data[] = "abcdef";
+    ring.push_back(data, 6);
+    ring.pop_front(nullptr, 4);
+
+    // free space wraps around the end of the buffer
+    space_tcp::region regions[2];
+    EXPECT_EQ(5, ring.writable(regions, 5));
+    EXPECT_EQ(mem + 6, regions[0].data);
+    EXPECT_EQ(2, regions[0].len);
+    EXPECT_EQ(mem, regions[1].data);
+    EXPECT_EQ(3, regions[1].len);
+
+    memcpy(regions[0].data, "gh", 2);
+    memcpy(regions[1].data, "ijk", 3);
+    EXPECT_TRUE(ring.advance_head(5));
+    EXPECT_EQ(7, ring.used_space());
+
+    // no more than the free space
+    EXPECT_EQ(1, ring.writable(regions, 100));
+    EXPECT_EQ(1, regions[0].len);
+    EXPECT_EQ(0, regions[1].len);
+
+    uint8_t popped[7];
+    EXPECT_EQ(7, ring.pop_front(popped, sizeof(popped)));
+    EXPECT_EQ(0, memcmp("efghijk", popped, sizeof(popped)));
+}
+
+TEST(RingTest, ReadableRegions) {
+    uint8_t mem[8]{};
+
+    auto ring = space_tcp::RingBuffer::create(mem, sizeof(mem));
+
+    space_tcp::const_region regions[2];
+    EXPECT_EQ(0, ring.readable(regions));
+    EXPECT_EQ(0, regions[0].len + regions[1].len);
+
+    uint8_t data[] = "abcdefgh";
+    ring.push_back(data, 6);
+    ring.pop_front(nullptr, 4);
+    ring.push_back(data, 4);
+
+    EXPECT_EQ(6, ring.readable(regions));
+    EXPECT_EQ(mem + 4, regions[0].data);
+    EXPECT_EQ(4, regions[0].len);
+    EXPECT_EQ(mem, regions[1].data);
+    EXPECT_EQ(2, regions[1].len);
+
+    EXPECT_EQ(0, memcmp("efab", regions[0].data, 4));
+    EXPECT_EQ(0, memcmp("cd", regions[1].data, 2));
+}
+
+TEST(RingTest, WrapAround) {
+    // masked and divided indices
+    for (size_t size : {5, 8}) {
+        uint8_t mem[8]{};
+
+        auto ring = space_tcp::RingBuffer::create(mem, size);
+
+        uint8_t next = 0;
+        uint8_t expected = 0;
+
+        for (size_t round = 0; round < 100; round++) {
+            uint8_t data[3] = {next, static_cast<uint8_t>(next + 1), static_cast<uint8_t>(next + 2)};
+            ASSERT_EQ(3, ring.push_back(data, 3));
+            next += 3;
+
+            uint8_t popped[3]{};
+            ASSERT_EQ(3, ring.pop_front(popped, 3));
+
+            for (auto byte : popped) {
+                ASSERT_EQ(expected++, byte);
+            }
+        }
+
+        EXPECT_TRUE(ring.empty());
+        EXPECT_EQ(size, ring.free_space());
+    }
+}
+
+TEST(RingTest, MirroredMemory) {
+    auto memory = space_tcp::MirroredMemory::create(100);
+
+    if (!memory.valid()) {
+        GTEST_SKIP() << "mirrored memory not supported";
+    }
+
+    // rounded up to pages, the second mapping shows the first one
+    ASSERT_GE(memory.size(), 100);
+    memory.data()[0] = 42;
+    EXPECT_EQ(42, memory.data()[memory.size()]);
+
+    auto ring = space_tcp::RingBuffer::create_mirrored(memory.data(), memory.size());
+
+    std::vector<uint8_t> data(memory.size());
+    ring.push_back(data.data(), memory.size() - 10);
+    ring.pop_front(nullptr, memory.size() - 10);
+
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+
+    // free space and data across the end of the buffer are contiguous
+    space_tcp::region writable[2];
+    EXPECT_EQ(100, ring.writable(writable, 100));
+    EXPECT_EQ(100, writable[0].len);
+    EXPECT_EQ(0, writable[1].len);
+
+    EXPECT_EQ(100, ring.push_back(data.data(), 100));
+
+    space_tcp::const_region readable[2];
+    EXPECT_EQ(100, ring.readable(readable));
+    ASSERT_EQ(100, readable[0].len);
+    EXPECT_EQ(0, memcmp(data.data(), readable[0].data, 100));
+
+    // the wrapped part landed at the start of the buffer
+    EXPECT_EQ(10, memory.data()[0]);
+}
+
+TEST(RingTest, ProducerConsumerThreads) {
+    uint8_t mem[97]{};
+    constexpr size_t TOTAL = 200000;
+
+    auto ring = space_tcp::RingBuffer::create(mem, sizeof(mem));
+
+    // one thread pushes a byte sequence, the other one pops it
+    std::thread producer{[&ring] {
+        uint8_t chunk[13];
+        size_t sent = 0;
+
+        while (sent < TOTAL) {
+            for (size_t i = 0; i < sizeof(chunk); i++) {
+                chunk[i] = static_cast<uint8_t>((sent + i) % 251);
+            }
+
+            auto len = (TOTAL - sent < sizeof(chunk)) ? TOTAL - sent : sizeof(chunk);
+            auto pushed = ring.push_back(chunk, len);
+
+            if (pushed > 0) {
+                sent += pushed;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    uint8_t chunk[31];
+    size_t received = 0;
+    bool in_order = true;
+
+    while (received < TOTAL) {
+        auto popped = ring.pop_front(chunk, sizeof(chunk));
+
+        for (ssize_t i = 0; i < popped; i++) {
+            in_order &= chunk[i] == static_cast<uint8_t>((received + i) % 251);
+        }
+
+        received += popped;
+
+        if (popped == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(ring.empty());
+}
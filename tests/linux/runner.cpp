@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/runner.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <poll.h>
+#include <vector>
+
+// Packets in flight from one end of a link to the other.
+struct Direction {
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::deque<std::vector<uint8_t>> packets;
+};
+
+// One end of a lossless link between two endpoints driven by different
+// threads.
+class LinkEnd : public space_tcp::NetworkInterface {
+public:
+    LinkEnd(Direction &in, Direction &out) : in{in}, out{out} {}
+
+    auto receive(uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        std::unique_lock<std::mutex> lock{in.mutex};
+
+        auto queued = [this] { return !in.packets.empty(); };
+
+        if (timeout < 0) {
+            in.arrived.wait(lock, queued);
+        } else if (!in.arrived.wait_for(lock, std::chrono::milliseconds(timeout), queued)) {
+            return -1;
+        }
+
+        auto &packet = in.packets.front();
+        len = (len > packet.size()) ? packet.size() : len;
+        memcpy(buffer, packet.data(), len);
+        in.packets.pop_front();
+
+        return len;
+    }
+
+    auto send(const uint8_t *buffer, size_t len, ssize_t timeout) -> ssize_t override {
+        {
+            std::lock_guard<std::mutex> lock{out.mutex};
+            out.packets.emplace_back(buffer, buffer + len);
+        }
+
+        out.arrived.notify_one();
+
+        return len;
+    }
+
+private:
+    Direction &in;
+    Direction &out;
+};
+
+class EndpointRunnerTest : public ::testing::Test {
+protected:
+    Direction a_to_b;
+    Direction b_to_a;
+    LinkEnd network_a{b_to_a, a_to_b};
+    LinkEnd network_b{a_to_b, b_to_a};
+
+    uint8_t space_tcp_buffer_a[1 << 12]{};
+    uint8_t connection_buffer_a[1 << 12]{};
+    space_tcp::Connections<1> connections_a;
+    space_tcp::TcpEndpoint endpoint_a = space_tcp::TcpEndpoint::create(space_tcp_buffer_a, sizeof(space_tcp_buffer_a),
+                                                                       connections_a, network_a);
+    space_tcp::Connection *connection_a = endpoint_a.create_connection(connection_buffer_a,
+                                                                       sizeof(connection_buffer_a), 13, 17);
+
+    uint8_t space_tcp_buffer_b[1 << 12]{};
+    uint8_t connection_buffer_b[1 << 12]{};
+    space_tcp::Connections<1> connections_b;
+    space_tcp::TcpEndpoint endpoint_b = space_tcp::TcpEndpoint::create(space_tcp_buffer_b, sizeof(space_tcp_buffer_b),
+                                                                       connections_b, network_b);
+    space_tcp::Connection *connection_b = endpoint_b.create_connection(connection_buffer_b,
+                                                                       sizeof(connection_buffer_b), 17, 13);
+
+    // the stack threads start last
+    space_tcp::EndpointRunner<2> runner_a = space_tcp::EndpointRunner<2>::create(endpoint_a, 2);
+    space_tcp::EndpointRunner<2> runner_b = space_tcp::EndpointRunner<2>::create(endpoint_b, 2);
+};
+
+TEST_F(EndpointRunnerTest, BlockingSendReceive) {
+    ASSERT_GE(runner_a.watch(connection_a), 0);
+    ASSERT_GE(runner_b.watch(connection_b), 0);
+
+    runner_b.call([this] { connection_b->listen(); });
+
+    std::vector<uint8_t> data(20000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i % 251);
+    }
+
+    // far more than fits into the transmit buffer
+    std::thread sender{[this, &data] {
+        EXPECT_EQ(static_cast<ssize_t>(data.size()), runner_a.send(connection_a, data.data(), data.size(), 10000));
+    }};
+
+    std::vector<uint8_t> received(data.size());
+    size_t len = 0;
+
+    while (len < received.size()) {
+        auto chunk = runner_b.receive(connection_b, received.data() + len, received.size() - len, 10000);
+
+        ASSERT_GT(chunk, 0);
+        len += chunk;
+    }
+
+    sender.join();
+
+    EXPECT_EQ(data, received);
+    EXPECT_EQ(space_tcp::State::Established, runner_b.state(connection_b));
+}
+
+TEST_F(EndpointRunnerTest, ReceiveTimeout) {
+    ASSERT_GE(runner_b.watch(connection_b), 0);
+
+    runner_b.call([this] { connection_b->listen(); });
+
+    uint8_t buffer[16];
+    auto start = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(0, runner_b.receive(connection_b, buffer, sizeof(buffer), 50));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+    // connections have to be watched
+    EXPECT_EQ(-1, runner_a.receive(connection_a, buffer, sizeof(buffer), 0));
+}
+
+TEST_F(EndpointRunnerTest, ReadinessNotifications) {
+    auto fd = runner_b.watch(connection_b);
+    ASSERT_GE(fd, 0);
+    ASSERT_GE(runner_a.watch(connection_a), 0);
+
+    // watching again returns the same eventfd
+    EXPECT_EQ(fd, runner_b.watch(connection_b));
+
+    runner_b.call([this] { connection_b->listen(); });
+
+    // the initial events tell what the connection can do right now
+    uint64_t count;
+    ASSERT_EQ(sizeof(count), read(fd, &count, sizeof(count)));
+    EXPECT_EQ(space_tcp::Event::Writable | space_tcp::Event::StateChange,
+              runner_b.events(connection_b) & (space_tcp::Event::Writable | space_tcp::Event::StateChange));
+
+    uint8_t data[] = "telemetry";
+    EXPECT_EQ(sizeof(data), runner_a.send(connection_a, data, sizeof(data), 1000));
+
+    // the application sleeps in poll() until data arrives
+    auto readable = space_tcp::Event::None;
+
+    while (readable == space_tcp::Event::None) {
+        pollfd poll_fd{fd, POLLIN, 0};
+        ASSERT_EQ(1, poll(&poll_fd, 1, 5000));
+        ASSERT_EQ(sizeof(count), read(fd, &count, sizeof(count)));
+
+        readable = runner_b.events(connection_b) & space_tcp::Event::Readable;
+    }
+
+    uint8_t buffer[sizeof(data)]{};
+    EXPECT_EQ(sizeof(data), runner_b.receive(connection_b, buffer, sizeof(buffer), 0));
+    EXPECT_EQ(0, memcmp(data, buffer, sizeof(data)));
+
+    // closing on the remote host ends a blocking receive long before its
+    // timeout and is reported as a state change
+    runner_b.events(connection_b);
+    runner_a.call([this] { connection_a->close(); });
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, runner_b.receive(connection_b, buffer, sizeof(buffer), 5000));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1000));
+
+    EXPECT_EQ(space_tcp::Event::StateChange, runner_b.wait(connection_b, space_tcp::Event::StateChange, 0));
+    EXPECT_NE(space_tcp::State::Established, runner_b.state(connection_b));
+}
@@ -68,4 +68,45 @@ TEST(SegmentTest, SmallestSegmentInsertAndDelete2) {
 
     EXPECT_EQ(true, segments.remove(7, 1));
     EXPECT_EQ(9, segments.get_smallest_offset_segment().offset);
-}
\ No newline at end of file
+}
+
+TEST(SegmentTest, SegmentAtOffsetZero) {
+    space_tcp::Segments<2> segments;
+
+    EXPECT_EQ(false, segments.contains_segments());
+    EXPECT_EQ(false, segments.insert(4, 0));
+
+    EXPECT_EQ(true, segments.insert(0, 4));
+    EXPECT_EQ(true, segments.contains_segments());
+    EXPECT_EQ(true, segments.contains(0, 4));
+    EXPECT_EQ(false, segments.contains(0, 3));
+    EXPECT_EQ(4, segments.get_smallest_offset_segment().len);
+
+    EXPECT_EQ(true, segments.remove(0, 4));
+    EXPECT_EQ(false, segments.contains_segments());
+}
+
+TEST(SegmentTest, Ranges) {
+    space_tcp::Segments<6> segments;
+    space_tcp::segment ranges[4]{};
+
+    EXPECT_EQ(0, segments.ranges(ranges, 4));
+
+    EXPECT_EQ(true, segments.insert(30, 10));
+    EXPECT_EQ(true, segments.insert(10, 5));
+    EXPECT_EQ(true, segments.insert(15, 5));
+    EXPECT_EQ(true, segments.insert(12, 2));
+    EXPECT_EQ(true, segments.insert(50, 5));
+
+    // adjacent and overlapping segments are merged
+    EXPECT_EQ(3, segments.ranges(ranges, 4));
+    EXPECT_EQ(10, ranges[0].offset);
+    EXPECT_EQ(10, ranges[0].len);
+    EXPECT_EQ(30, ranges[1].offset);
+    EXPECT_EQ(10, ranges[1].len);
+    EXPECT_EQ(50, ranges[2].offset);
+    EXPECT_EQ(5, ranges[2].len);
+
+    EXPECT_EQ(2, segments.ranges(ranges, 2));
+    EXPECT_EQ(30, ranges[1].offset);
+}
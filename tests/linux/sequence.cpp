@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/sequence.hpp"
+
+using namespace space_tcp;
+
+TEST(SequenceTest, Compare) {
+    EXPECT_TRUE(seq_lt<uint16_t>(1, 2));
+    EXPECT_FALSE(seq_lt<uint16_t>(2, 1));
+    EXPECT_FALSE(seq_lt<uint16_t>(2, 2));
+
+    EXPECT_TRUE(seq_leq<uint16_t>(2, 2));
+    EXPECT_TRUE(seq_gt<uint16_t>(2, 1));
+    EXPECT_TRUE(seq_geq<uint16_t>(2, 2));
+    EXPECT_FALSE(seq_geq<uint16_t>(1, 2));
+}
+
+TEST(SequenceTest, CompareWrapAround) {
+    // 0x0010 follows 0xfff0 although it is numerically smaller
+    EXPECT_TRUE(seq_lt<uint16_t>(0xfff0, 0x0010));
+    EXPECT_TRUE(seq_gt<uint16_t>(0x0010, 0xfff0));
+
+    EXPECT_TRUE(seq_lt<uint32_t>(0xfffffff0, 0x00000010));
+    EXPECT_TRUE(seq_gt<uint32_t>(0x00000010, 0xfffffff0));
+
+    // less than half the sequence space ahead
+    EXPECT_TRUE(seq_lt<uint16_t>(0x0000, 0x7fff));
+    EXPECT_TRUE(seq_gt<uint16_t>(0x0000, 0x8001));
+}
+
+TEST(SequenceTest, Extend) {
+    EXPECT_EQ(0x00001234u, seq_extend(0x1234, 0x00001000));
+    EXPECT_EQ(0x00051234u, seq_extend(0x1234, 0x00051000));
+
+    // 16-bit sequence number wrapped around, reference did not
+    EXPECT_EQ(0x00060010u, seq_extend(0x0010, 0x0005fff0));
+
+    // reference wrapped around, 16-bit sequence number did not
+    EXPECT_EQ(0x0005fff0u, seq_extend(0xfff0, 0x00060010));
+
+    // 32-bit sequence space wraps around, too
+    EXPECT_EQ(0x00000010u, seq_extend(0x0010, 0xfffffff0));
+}
@@ -173,3 +173,203 @@ TEST_F(S3tpTest, PadMessage) {
 
     EXPECT_EQ(16, packet_1.size());
 }
+
+TEST_F(S3tpTest, ExtendedSequenceNumbers) {
+    uint8_t data[64]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x12345678, true);
+    packet.set_ack_num(0x9abcdef0);
+
+    EXPECT_TRUE(packet.is_extended());
+    EXPECT_EQ(0x2, packet.msg_type());
+    EXPECT_EQ(48, packet.header_size());
+    EXPECT_EQ(data + 48, packet.payload());
+    EXPECT_EQ(0x12345678u, packet.seq_num());
+    EXPECT_EQ(0x9abcdef0u, packet.ack_num());
+
+    // lower halves are stored in the standard header fields
+    EXPECT_EQ(0x56, data[6]);
+    EXPECT_EQ(0x78, data[7]);
+    EXPECT_EQ(0xde, data[8]);
+    EXPECT_EQ(0xf0, data[9]);
+}
+
+TEST_F(S3tpTest, StandardSequenceNumbers) {
+    uint8_t data[64]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x12345678);
+
+    EXPECT_FALSE(packet.is_extended());
+    EXPECT_EQ(44, packet.header_size());
+    EXPECT_EQ(0x5678u, packet.seq_num());
+}
+
+TEST_F(S3tpTest, Options) {
+    uint8_t data[128]{};
+    uint8_t payload[] = "payload";
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_flags(space_tcp::Flag::Syn);
+
+    EXPECT_EQ(0, packet.options_size());
+    EXPECT_EQ(0, packet.mss_option());
+
+    EXPECT_TRUE(packet.set_mss_option(1400));
+    packet.set_payload(payload, sizeof(payload));
+
+    EXPECT_EQ(space_tcp::Flag::Syn | space_tcp::Flag::Opt, packet.flags());
+    EXPECT_EQ(5, packet.options_size());
+    EXPECT_EQ(49, packet.header_size());
+    EXPECT_EQ(1400, packet.mss_option());
+    EXPECT_EQ(0, memcmp(data + 49, payload, sizeof(payload)));
+    EXPECT_EQ(49 + sizeof(payload), packet.length());
+}
+
+TEST_F(S3tpTest, MalformedOptions) {
+    uint8_t data[64]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_flags(space_tcp::Flag::Opt);
+
+    // option claims more bytes than the options block holds
+    data[44] = 3;
+    data[45] = static_cast<uint8_t>(space_tcp::Option::Mss);
+    data[46] = 2;
+
+    EXPECT_EQ(0, packet.mss_option());
+}
+
+TEST_F(S3tpTest, SackOption) {
+    uint8_t data[128]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_flags(space_tcp::Flag::Ack);
+
+    space_tcp::seq_range ranges[space_tcp::MAX_SACK_BLOCKS];
+    EXPECT_EQ(0, packet.sack_option(ranges, space_tcp::MAX_SACK_BLOCKS));
+
+    space_tcp::seq_range blocks[] = {{0x00011000, 0x00011200}, {0xfffffff0, 0x00000010}};
+    EXPECT_TRUE(packet.set_sack_option(blocks, 2));
+    EXPECT_EQ(1 + 2 + 16, packet.options_size());
+
+    EXPECT_EQ(2, packet.sack_option(ranges, space_tcp::MAX_SACK_BLOCKS));
+    EXPECT_EQ(0x00011000u, ranges[0].start);
+    EXPECT_EQ(0x00011200u, ranges[0].end);
+    EXPECT_EQ(0xfffffff0u, ranges[1].start);
+    EXPECT_EQ(0x00000010u, ranges[1].end);
+
+    EXPECT_EQ(1, packet.sack_option(ranges, 1));
+}
+
+TEST_F(S3tpTest, FecOptions) {
+    uint8_t data[128]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+
+    space_tcp::fec_tag tag{};
+    EXPECT_FALSE(packet.fec_option(tag));
+
+    EXPECT_TRUE(packet.set_fec_option({0x0102, 3, 2}));
+    EXPECT_TRUE(packet.fec_option(tag));
+    EXPECT_EQ(0x0102, tag.group);
+    EXPECT_EQ(3, tag.index);
+    EXPECT_EQ(2, tag.lanes);
+
+    // repair packets carry 32-bit sequence numbers
+    packet.initialize(0xaabb, 0xccdd, 0x00011234, true);
+    packet.set_msg_type(static_cast<uint8_t>(space_tcp::MsgType::Repair));
+    EXPECT_TRUE(packet.is_repair());
+    EXPECT_TRUE(packet.is_extended());
+    EXPECT_EQ(0x00011234u, packet.seq_num());
+
+    space_tcp::seq_range segments[] = {{0x00011234, 0x00011434}, {0x00011634, 0x00011700}};
+    EXPECT_TRUE(packet.set_repair_option({0x0102, 1, 2}, segments, 2));
+    EXPECT_EQ(1 + 2 + 4 + 12, packet.options_size());
+
+    space_tcp::seq_range parsed[space_tcp::ForwardErrorCorrection::MAX_LANE_SEGMENTS];
+    EXPECT_EQ(2, packet.repair_option(tag, parsed, space_tcp::ForwardErrorCorrection::MAX_LANE_SEGMENTS));
+    EXPECT_EQ(1, tag.index);
+    EXPECT_EQ(0x00011634u, parsed[1].start);
+    EXPECT_EQ(0x00011700u, parsed[1].end);
+}
+
+TEST_F(S3tpTest, RepairPacketIv) {
+    uint8_t data[64]{};
+    uint8_t repair_data[64]{};
+    uint8_t iv[16]{0x20, 0x2F, 0x82, 0x2D, 0xE1, 0xE4, 0x05, 0xA6, 0x1A, 0x3F, 0x61, 0xE0, 0x6D, 0xE8, 0x13, 0x8F};
+
+    // the repair packet of a group carries the sequence number of its first
+    // data segment
+    auto segment = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    segment.initialize(0xaabb, 0xccdd, 0x00011234, true);
+
+    auto repair = space_tcp::SpaceTcpPacket::create_unchecked(repair_data, sizeof(repair_data));
+    repair.initialize(0xaabb, 0xccdd, 0x00011234, true);
+    repair.set_msg_type(static_cast<uint8_t>(space_tcp::MsgType::Repair));
+
+    uint8_t segment_iv[16];
+    uint8_t repair_iv[16];
+    segment.message_iv(iv, segment_iv);
+    repair.message_iv(iv, repair_iv);
+
+    EXPECT_NE(0, memcmp(segment_iv, repair_iv, sizeof(iv)));
+
+    // standard segments keep the IV of earlier versions
+    segment.initialize(0xaabb, 0xccdd, 0x1234);
+    segment.message_iv(iv, segment_iv);
+
+    EXPECT_EQ(iv[0] ^ 0x12, segment_iv[0]);
+    EXPECT_EQ(iv[1] ^ 0x34, segment_iv[1]);
+    EXPECT_EQ(0, memcmp(iv + 2, segment_iv + 2, sizeof(iv) - 2));
+}
+
+TEST_F(S3tpTest, WindowOption) {
+    uint8_t data[128]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_flags(space_tcp::Flag::Ack);
+
+    uint32_t window;
+    EXPECT_FALSE(packet.window_option(window));
+
+    EXPECT_TRUE(packet.set_window_option(0x00012345));
+    EXPECT_EQ(1 + 2 + 4, packet.options_size());
+
+    EXPECT_TRUE(packet.window_option(window));
+    EXPECT_EQ(0x00012345u, window);
+}
+
+TEST_F(S3tpTest, CompressedPayload) {
+    uint8_t data[256]{};
+
+    auto packet = space_tcp::SpaceTcpPacket::create_unchecked(data, sizeof(data));
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_flags(space_tcp::Flag::Syn);
+
+    EXPECT_EQ(space_tcp::Compression::None, packet.compression_option());
+    EXPECT_TRUE(packet.set_compression_option(space_tcp::Compression::Lz));
+    EXPECT_EQ(space_tcp::Compression::Lz, packet.compression_option());
+
+    uint8_t payload[100];
+    memset(payload, 'x', sizeof(payload));
+
+    auto compressor = space_tcp::LzCompressor::create();
+    packet.initialize(0xaabb, 0xccdd, 0x1234);
+    packet.set_size(static_cast<uint16_t>(compressor.compress(payload, sizeof(payload), nullptr, 0, packet.payload())));
+    packet.set_flags(space_tcp::Flag::Cmp);
+
+    ASSERT_GT(packet.size(), 0);
+    EXPECT_LT(packet.size(), sizeof(payload));
+
+    EXPECT_TRUE(packet.decompress_payload());
+    EXPECT_EQ(space_tcp::Flag::NoFlags, packet.flags());
+    ASSERT_EQ(sizeof(payload), packet.size());
+    EXPECT_EQ(0, memcmp(payload, packet.payload(), sizeof(payload)));
+}
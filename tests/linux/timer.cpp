@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/timer.hpp"
+
+struct Timer {
+    space_tcp::ListHook<Timer> hook;
+    space_tcp::TimerEntry entry;
+};
+
+using Wheel = space_tcp::TimerWheel<Timer, &Timer::hook, &Timer::entry, 64>;
+
+TEST(TimerWheelTest, Empty) {
+    Wheel wheel;
+
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(UINT64_MAX, wheel.earliest());
+    EXPECT_EQ(nullptr, wheel.pop_expired(1000));
+}
+
+TEST(TimerWheelTest, ExpiresInOrderOfDeadlines) {
+    Wheel wheel;
+    Timer a, b, c;
+
+    wheel.pop_expired(1000);
+
+    // deadlines in any order
+    EXPECT_TRUE(wheel.insert(&b, 1020));
+    EXPECT_TRUE(wheel.insert(&c, 1030));
+    EXPECT_TRUE(wheel.insert(&a, 1010));
+    EXPECT_FALSE(wheel.insert(&a, 1040));
+    EXPECT_EQ(3, wheel.size());
+    EXPECT_EQ(1010, wheel.earliest());
+
+    // timers expire once their deadline is reached
+    EXPECT_EQ(nullptr, wheel.pop_expired(1009));
+    EXPECT_EQ(&a, wheel.pop_expired(1010));
+    EXPECT_EQ(nullptr, wheel.pop_expired(1010));
+    EXPECT_EQ(1020, wheel.earliest());
+
+    EXPECT_EQ(&b, wheel.pop_expired(1050));
+    EXPECT_EQ(&c, wheel.pop_expired(1050));
+    EXPECT_EQ(nullptr, wheel.pop_expired(1050));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, ExpiresAtDeadline) {
+    Wheel wheel;
+    Timer a, b;
+
+    wheel.pop_expired(1000);
+    wheel.insert(&a, 1005);
+
+    EXPECT_EQ(nullptr, wheel.pop_expired(1004));
+    EXPECT_EQ(&a, wheel.pop_expired(1005));
+
+    // inserted into the slot the wheel has reached
+    wheel.insert(&b, 1005);
+    EXPECT_EQ(&b, wheel.pop_expired(1005));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, Remove) {
+    Wheel wheel;
+    Timer a, b;
+
+    wheel.insert(&a, 10);
+    wheel.insert(&b, 20);
+
+    EXPECT_TRUE(wheel.remove(&a));
+    EXPECT_FALSE(wheel.remove(&a));
+    EXPECT_FALSE(Wheel::contains(&a));
+    EXPECT_EQ(20, wheel.earliest());
+
+    EXPECT_EQ(&b, wheel.pop_expired(100));
+    EXPECT_EQ(nullptr, wheel.pop_expired(100));
+}
+
+TEST(TimerWheelTest, PassedDeadline) {
+    Wheel wheel;
+    Timer a;
+
+    wheel.pop_expired(1000);
+
+    // e.g., an ACK due right away
+    wheel.insert(&a, 0);
+
+    EXPECT_EQ(0, wheel.earliest());
+    EXPECT_EQ(&a, wheel.pop_expired(1000));
+}
+
+TEST(TimerWheelTest, DeadlinesBeyondOneTurn) {
+    Wheel wheel;
+    Timer a, b;
+
+    wheel.pop_expired(1000);
+
+    // both timers share a slot, one of them a turn later
+    wheel.insert(&a, 1000 + 64 + 5);
+    wheel.insert(&b, 1005);
+    EXPECT_EQ(1005, wheel.earliest());
+
+    EXPECT_EQ(&b, wheel.pop_expired(1006));
+    EXPECT_EQ(nullptr, wheel.pop_expired(1006));
+    EXPECT_EQ(1069, wheel.earliest());
+
+    EXPECT_EQ(nullptr, wheel.pop_expired(1068));
+    EXPECT_EQ(&a, wheel.pop_expired(1069));
+
+    // far ahead
+    wheel.insert(&a, 100000);
+    EXPECT_EQ(100000, wheel.earliest());
+    EXPECT_EQ(nullptr, wheel.pop_expired(99999));
+    EXPECT_EQ(&a, wheel.pop_expired(200000));
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "space_tcp/network/tun.hpp"
+#include "protocol/ipv4.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+// A datagram socket pair stands in for the TUN device, it keeps packet
+// boundaries like the device does.
+class TunTest : public ::testing::Test {
+public:
+    TunTest() : fds{make_socket_pair()},
+                tun{space_tcp::TunInterface::attach(fds[0], tun_buffer, sizeof(tun_buffer))} {}
+
+    ~TunTest() override {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+protected:
+    static auto make_socket_pair() -> std::array<int, 2> {
+        std::array<int, 2> pair{};
+        EXPECT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, pair.data()), 0);
+        return pair;
+    }
+
+    // sends an IPv4 packet of `protocol` from the peer (10.0.7.1) to the
+    // interface (10.0.6.1)
+    void inject(uint8_t protocol, const uint8_t *payload, size_t len) {
+        uint8_t data[128]{};
+        auto packet = space_tcp::Ipv4Packet::create_unchecked(data, sizeof(data));
+
+        packet.initialize(1, 0x0a000701, 0x0a000601);
+        packet.set_protocol(protocol);
+        packet.set_payload(payload, len);
+        packet.update_checksum();
+
+        ASSERT_EQ(send(fds[1], data, packet.length(), 0), packet.length());
+    }
+
+    std::array<int, 2> fds;
+    uint8_t tun_buffer[1500]{};
+    space_tcp::TunInterface tun;
+
+    uint8_t payload[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+};
+
+TEST_F(TunTest, ReceivePacket) {
+    inject(0x99, payload, sizeof(payload));
+
+    uint8_t buffer[64];
+    ASSERT_EQ(tun.receive(buffer, sizeof(buffer), 100), static_cast<ssize_t>(sizeof(payload)));
+    ASSERT_EQ(memcmp(buffer, payload, sizeof(payload)), 0);
+}
+
+TEST_F(TunTest, Timeout) {
+    uint8_t buffer[64];
+    ASSERT_EQ(tun.receive(buffer, sizeof(buffer), 10), -1);
+}
+
+TEST_F(TunTest, DroppedPacketBeforeValidPacket) {
+    // UDP packets are dropped
+    inject(17, payload, sizeof(payload));
+    inject(0x99, payload, 4);
+
+    uint8_t buffer[64];
+    ASSERT_EQ(tun.receive(buffer, sizeof(buffer), 100), 4);
+    ASSERT_EQ(memcmp(buffer, payload, 4), 0);
+}
+
+TEST_F(TunTest, WaitAfterDroppedPacket) {
+    inject(17, payload, sizeof(payload));
+
+    // the valid packet arrives after the dropped one woke up the receiver
+    std::thread sender([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        inject(0x99, payload, sizeof(payload));
+    });
+
+    uint8_t buffer[64];
+    auto bytes = tun.receive(buffer, sizeof(buffer), 1000);
+    sender.join();
+
+    ASSERT_EQ(bytes, static_cast<ssize_t>(sizeof(payload)));
+}
+
+TEST_F(TunTest, TimeoutAfterDroppedPacket) {
+    inject(17, payload, sizeof(payload));
+
+    uint8_t buffer[64];
+    ASSERT_EQ(tun.receive(buffer, sizeof(buffer), 10), -1);
+}
@@ -7,14 +7,20 @@ set_not_set = {
 
 msg_types = {
     [0] = "Invalid message type",
-    [1] = "Standard"
+    [1] = "Standard",
+    [2] = "Extended",
+    [3] = "Repair",
+    [4] = "Fountain"
 }
 
 flag_syn = ProtoField.uint8("s3tp.flags.syn", "SYN",           base.HEX, set_not_set, 0x01)
 flag_ack = ProtoField.uint8("s3tp.flags.ack", "ACK",           base.HEX, set_not_set, 0x02)
 flag_rst = ProtoField.uint8("s3tp.flags.rst", "RESET",         base.HEX, set_not_set, 0x04)
 flag_fin = ProtoField.uint8("s3tp.flags.fin", "FIN",           base.HEX, set_not_set, 0x08)
-flag_rsv = ProtoField.uint8("s3tp.flags.rsv", "Reserved bits", base.HEX, nil, 0xf0)
+flag_opt = ProtoField.uint8("s3tp.flags.opt", "OPTIONS",       base.HEX, set_not_set, 0x10)
+flag_cmp = ProtoField.uint8("s3tp.flags.cmp", "COMPRESSED",    base.HEX, set_not_set, 0x20)
+flag_ook = ProtoField.uint8("s3tp.flags.optok", "OPTIONS OK", base.HEX, set_not_set, 0x40)
+flag_rsv = ProtoField.uint8("s3tp.flags.rsv", "Reserved bits", base.HEX, nil, 0x80)
 
 version  = ProtoField.uint8( "s3tp.version",  "Version",                base.DEC, nil, 0xf0)
 msg_type = ProtoField.uint8( "s3tp.msg_type", "Message Type",           base.DEC, msg_types, 0x0f)
@@ -24,12 +30,33 @@ dst_port = ProtoField.uint16("s3tp.dst_port", "Destination Port",       base.DEC
 seq_num  = ProtoField.uint16("s3tp.seq_num",  "Sequence Number",        base.DEC)
 ack_num  = ProtoField.uint16("s3tp.ack_num",  "Acknowledgment Number",  base.DEC)
 size     = ProtoField.uint16("s3tp.size",     "Size",                   base.DEC)
+seq_high = ProtoField.uint16("s3tp.seq_high", "Sequence Number (high)", base.DEC)
+ack_high = ProtoField.uint16("s3tp.ack_high", "Acknowledgment Number (high)", base.DEC)
 hmac     = ProtoField.none(  "s3tp.hmac",     "HMAC")
+options  = ProtoField.none(  "s3tp.options",  "Options")
+opt_mss  = ProtoField.uint16("s3tp.options.mss", "Maximum Segment Size", base.DEC)
+opt_sack = ProtoField.none(  "s3tp.options.sack", "Selective Acknowledgment")
+sack_start = ProtoField.uint32("s3tp.options.sack.start", "Start", base.DEC)
+sack_end   = ProtoField.uint32("s3tp.options.sack.end",   "End",   base.DEC)
+opt_window = ProtoField.uint32("s3tp.options.window", "Receive Window", base.DEC)
+opt_fec    = ProtoField.none(  "s3tp.options.fec", "Forward Error Correction")
+opt_repair = ProtoField.none(  "s3tp.options.repair", "Repair")
+fec_group  = ProtoField.uint16("s3tp.options.fec.group", "Group", base.DEC)
+fec_index  = ProtoField.uint8( "s3tp.options.fec.index", "Index", base.DEC)
+fec_lanes  = ProtoField.uint8( "s3tp.options.fec.lanes", "Lanes", base.DEC)
+repair_seq = ProtoField.uint32("s3tp.options.repair.seq", "Sequence Number", base.DEC)
+repair_len = ProtoField.uint16("s3tp.options.repair.len", "Length", base.DEC)
+opt_object = ProtoField.uint32("s3tp.options.object", "Object Size", base.DEC)
+opt_compression = ProtoField.uint8("s3tp.options.compression", "Compression", base.DEC, { [0] = "None", [1] = "LZ" })
 payload  = ProtoField.none(  "s3tp.payload",  "Payload")
 
 s3tp_protocol.fields = { version, msg_type, flags, flag_syn, flag_ack, flag_rst,
-                         flag_fin, flag_rsv, src_port, dst_port,
-                         seq_num, ack_num, size, hmac, payload }
+                         flag_fin, flag_opt, flag_cmp, flag_ook, flag_rsv, src_port, dst_port,
+                         seq_num, ack_num, size, seq_high, ack_high, hmac,
+                         options, opt_mss, opt_sack, sack_start, sack_end, opt_window,
+                         opt_fec, opt_repair, fec_group, fec_index, fec_lanes,
+                         repair_seq, repair_len, opt_object, opt_compression,
+                         payload }
 
 function s3tp_protocol.dissector(buffer, pinfo, tree)
   length = buffer:len()
@@ -45,6 +72,10 @@ function s3tp_protocol.dissector(buffer, pinfo, tree)
 
   local payload_size = buffer(10, 2):uint()
 
+  -- extended, repair and fountain messages carry the upper halves of 32-bit sequence numbers
+  local header_size = 44
+  if buffer(0, 1):bitfield(4, 4) >= 2 then header_size = 48 end
+
   subtree:add(version,  buffer(0,  1))
   subtree:add(msg_type, buffer(0,  1))
   local flag_tree = subtree:add(flags, buffer(1, 1))
@@ -54,12 +85,61 @@ function s3tp_protocol.dissector(buffer, pinfo, tree)
   subtree:add(ack_num,  buffer(8,  2))
   subtree:add(size,     buffer(10, 2))
   subtree:add(hmac,     buffer(12, 32))
-  subtree:add(payload,  buffer(44, payload_size))
+  if header_size == 48 then
+    subtree:add(seq_high, buffer(44, 2))
+    subtree:add(ack_high, buffer(46, 2))
+  end
+
+  -- options block: length byte followed by type-length-value options
+  if bit.band(buffer(1, 1):uint(), 0x10) ~= 0 then
+    local options_size = buffer(header_size, 1):uint()
+    local options_tree = subtree:add(options, buffer(header_size, 1 + options_size))
+    local offset = header_size + 1
+
+    while offset + 2 <= header_size + 1 + options_size do
+      local option_type = buffer(offset, 1):uint()
+      local option_len = buffer(offset + 1, 1):uint()
+
+      if option_type == 1 and option_len == 2 then
+        options_tree:add(opt_mss, buffer(offset + 2, 2))
+      elseif option_type == 2 and option_len % 8 == 0 then
+        local sack_tree = options_tree:add(opt_sack, buffer(offset + 2, option_len))
+        for block = offset + 2, offset + option_len, 8 do
+          sack_tree:add(sack_start, buffer(block, 4))
+          sack_tree:add(sack_end,   buffer(block + 4, 4))
+        end
+      elseif option_type == 3 and option_len == 4 then
+        options_tree:add(opt_window, buffer(offset + 2, 4))
+      elseif (option_type == 4 and option_len == 4) or (option_type == 5 and option_len >= 4 and (option_len - 4) % 6 == 0) then
+        local fec_tree = options_tree:add(option_type == 4 and opt_fec or opt_repair, buffer(offset + 2, option_len))
+        fec_tree:add(fec_group, buffer(offset + 2, 2))
+        fec_tree:add(fec_index, buffer(offset + 4, 1))
+        fec_tree:add(fec_lanes, buffer(offset + 5, 1))
+        for segment = offset + 6, offset + 1 + option_len, 6 do
+          fec_tree:add(repair_seq, buffer(segment, 4))
+          fec_tree:add(repair_len, buffer(segment + 4, 2))
+        end
+      elseif option_type == 6 and option_len == 4 then
+        options_tree:add(opt_object, buffer(offset + 2, 4))
+      elseif option_type == 7 and option_len == 1 then
+        options_tree:add(opt_compression, buffer(offset + 2, 1))
+      end
+
+      offset = offset + 2 + option_len
+    end
+
+    header_size = header_size + 1 + options_size
+  end
+
+  subtree:add(payload,  buffer(header_size, payload_size))
 
   flag_tree:add(flag_syn,      buffer(1, 1))
   flag_tree:add(flag_ack,      buffer(1, 1))
   flag_tree:add(flag_rst,      buffer(1, 1))
   flag_tree:add(flag_fin,      buffer(1, 1))
+  flag_tree:add(flag_opt,      buffer(1, 1))
+  flag_tree:add(flag_cmp,      buffer(1, 1))
+  flag_tree:add(flag_ook,      buffer(1, 1))
   flag_tree:add(flag_rsv,      buffer(1, 1))
 
   -- pinfo.cols.info:append(" " .. tostring(pinfo.src_port).." -> "..tostring(pinfo.dst_port))